@@ -19,7 +19,11 @@
 #include "datalogger.h"
 #include <Cmd.h>
 #include "system/measurement_components.h"
+#include "system/idle.h"
 #include "system/monitor.h"
+#include "system/serial_tx.h"
+#include "system/trace.h"
+#include "system/memory.h"
 #include "system/watchdog.h"
 #include "system/command.h"
 #include "sensors/sensor_map.h"
@@ -30,53 +34,22 @@
 #include "scratch/dbgmcu.h"
 #include "system/logs.h"
 
-void Datalogger::sleepMCU(uint32 milliseconds)
-{
-  if(milliseconds < 5)
-  {
-    delay(milliseconds);
-    return;
-  }
-
-  setNextAlarmInternalRTCMilliseconds(milliseconds);
-
-  int iser1, iser2, iser3;
-  storeAllInterrupts(iser1, iser2, iser3);
-
-  disableCustomWatchDog();
-  disableSerialLog();
-
-  clearAllInterrupts();
-  clearAllPendingInterrupts();
-
-  nvic_irq_enable(NVIC_RTCALARM); // enable our RTC alarm interrupt
-
-  enterSleepMode();
-
-  nvic_irq_disable(NVIC_RTCALARM);
-
-  reenableAllInterrupts(iser1, iser2, iser3);
-
-  offsetMillis -= milliseconds; // account for millisecond count while systick was off
-
-  enableSerialLog();
-  startCustomWatchDog();
-
-  reloadCustomWatchdog();
-}
-
+ConfigurationStore dataloggerConfigurationStore(EEPROM_I2C_ADDRESS, EEPROM_DATALOGGER_CONFIGURATION_START);
+bool configurationCached = false; // flash configuration cache matches EEPROM, boot reads come from the cache
 
 // static method to read configuration from EEPROM
 void Datalogger::readConfiguration(datalogger_settings_type *settings)
 {
-  byte *buffer = (byte *)malloc(sizeof(byte) * sizeof(datalogger_settings_type));
-  for (unsigned short i = 0; i < sizeof(datalogger_settings_type); i++)
+  configurationCached = configurationCacheIsValid();
+  if (configurationCached)
   {
-    short address = EEPROM_DATALOGGER_CONFIGURATION_START + i;
-    buffer[i] = readEEPROM(&Wire, EEPROM_I2C_ADDRESS, address);
+    dataloggerConfigurationStore.load(configurationCache()->dataloggerConfiguration);
   }
-
-  memcpy(settings, buffer, sizeof(datalogger_settings_type));
+  else
+  {
+    dataloggerConfigurationStore.load();
+  }
+  dataloggerConfigurationStore.read(settings, sizeof(datalogger_settings_type));
 
   // apply defaults
   if (settings->burstNumber == 0 || settings->burstNumber > 20)
@@ -88,6 +61,18 @@ void Datalogger::readConfiguration(datalogger_settings_type *settings)
     settings->interBurstDelay = 0;
   }
 
+  if (settings->batteryFullScaleMillivolts == 0 || settings->batteryFullScaleMillivolts == 0xFFFF)
+  {
+    settings->batteryFullScaleMillivolts = BATTERY_DEFAULT_FULL_SCALE_MILLIVOLTS;
+  }
+  for (unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    if (settings->batteryTierDecivolts[i] == 0xFF)
+    {
+      settings->batteryTierDecivolts[i] = 0; // tiers are off until configured
+    }
+  }
+
   settings->debug_values = true;
   settings->log_raw_data = true;
 }
@@ -96,6 +81,15 @@ Datalogger::Datalogger(datalogger_settings_type *settings)
 {
   powerCycle = true;
 
+  memset(drivers, 0, sizeof(drivers));
+  memset(slotDrivers, 0, sizeof(slotDrivers));
+  memset(sensorDue, 0, sizeof(sensorDue));
+  memset(burstsRemaining, 0, sizeof(burstsRemaining));
+  memset(sensorRunning, 0, sizeof(sensorRunning));
+  memset(sensorHibernating, 0, sizeof(sensorHibernating));
+  memset(sensorStartedAt, 0, sizeof(sensorStartedAt));
+  memset(sampleCapturedAt, 0, sizeof(sampleCapturedAt));
+
   // defaults
   if (settings->interval < 1)
   {
@@ -103,6 +97,7 @@ Datalogger::Datalogger(datalogger_settings_type *settings)
   }
 
   memcpy(&this->settings, settings, sizeof(datalogger_settings_type));
+  configureBatteryPolicy();
 
   switch (settings->mode)
   {
@@ -123,14 +118,28 @@ Datalogger::Datalogger(datalogger_settings_type *settings)
 
 void Datalogger::setup()
 {
-  startCustomWatchDog();
+  startInternalRTC();
+  syncClock();
 
   setupHardwarePins();
   setupSwitchedPower();
   powerUpSwitchableComponents();
 
+  // probe for the external ADC once, drivers that use it power it up on demand
+  acquirePowerDomains(POWER_DOMAIN_EXTERNAL_ADC);
   bool externalADCInstalled = scanIC2(&Wire, 0x2f);
   settings.externalADCEnabled = externalADCInstalled;
+  if (externalADCInstalled)
+  {
+    debug(F("Set up extADC"));
+    externalADC = new AD7091R();
+    configureExternalADC();
+  }
+  else
+  {
+    debug(F("extADC not installed"));
+  }
+  releasePowerDomains(POWER_DOMAIN_EXTERNAL_ADC);
 
   setupManualWakeInterrupts();
   disableManualWakeInterrupt(); // don't respond to interrupt during setup
@@ -141,15 +150,21 @@ void Datalogger::setup()
   //initBLE();
 
   unsigned char uuid[UUID_LENGTH];
-  readUniqueId(uuid);
+  if (configurationCached)
+  {
+    memcpy(uuid, configurationCache()->uuid, UUID_LENGTH);
+  }
+  else
+  {
+    readUniqueId(uuid);
+  }
 
   decodeUniqueId(uuid, uuidString, UUID_LENGTH);
 
   checkMemory();
-  buildDriverSensorMap();
-  debug("Built driver sensor map");
   loadSensorConfigurations();
   debug("Loaded sensor configurations");
+  refreshConfigurationCache();
   initializeFilesystem();
   setUpCLI();
 }
@@ -160,8 +175,14 @@ void Datalogger::setup()
 */
 bool Datalogger::processReadingsCycle()
 {
+  if (sensorCount > 0 && !sensorsDue())
+  {
+    // awoken before any slot deadline, e.g. by the user
+    return false;
+  }
+
   measureSensorValues();
-  if (settings.log_raw_data) // we are really talking about a burst summary
+  if (settings.log_raw_data && battery.rawLoggingAllowed()) // we are really talking about a burst summary
   {
     writeRawMeasurementToLogFile();
   }
@@ -172,30 +193,39 @@ bool Datalogger::processReadingsCycle()
     // ask all drivers for maximum time until next burst reading
     // ask all drivers for maximum time until next available reading
     // sleep for whichever is less
-    notify(minMillisecondsUntilNextReading());
-    sleepMCU(minMillisecondsUntilNextReading());
+    LOG_DEBUGF("next reading in %d ms", minMillisecondsUntilNextReading());
+    sleepWithSensorsInStandby(minMillisecondsUntilNextReading());
     return true;
   }
 
-  // otherwise burse cycle completed,
-  completedBursts++;
-
+  // otherwise burst cycle completed,
   // so output burst summary
   writeSummaryMeasurementToLogFile();
 
-  if (completedBursts < settings.burstNumber)
+  // each slot runs its own number of bursts
+  bool anotherBurst = false;
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    unsigned short slot = drivers[i]->getSlot();
+    if (burstsRemaining[slot] > 0)
+    {
+      burstsRemaining[slot]--;
+      if (burstsRemaining[slot] > 0)
+      {
+        anotherBurst = true;
+      }
+    }
+  }
+
+  if (anotherBurst)
   {
     // debug(F("do another burst"));
 
     if (settings.interBurstDelay > 0)
     {
-      notify(F("burst delay"));
+      LOG_DEBUG(F("burst delay"));
       int interBurstDelay = settings.interBurstDelay * 60; // convert to seconds
-      // todo: we should sleep any sensors that can be slept without re-warming
-      // this could be called 'standby' mode
-      // placeSensorsInStandbyMode();
-      sleepMCU(interBurstDelay * 1000); // convert seconds to milliseconds
-      // wakeSensorsFromStandbyMode();
+      sleepWithSensorsInStandby(interBurstDelay * 1000); // convert seconds to milliseconds
     }
 
     initializeBurst();
@@ -215,10 +245,13 @@ void Datalogger::testMeasurementCycle()
   }      
   fileSystemWriteCache->flushCache();            // instead of using a boolean in this particular write cache
   fileSystemWriteCache->setOutputToSerial(false);// and then set it back to the original writecache here
+  selectAllSensors(); // interactive logging outputs every slot
 }
 
 void Datalogger::loop()
 {
+  setWatchdogPhase(inMode(interactive) || inMode(debugging) ? watchdog_cli : watchdog_measurement);
+
   if (inMode(deploy_on_trigger))
   {
     deploy(); // if deploy returns false here, the trigger setup has a fatal coding defect not detecting invalid conditions for deployment
@@ -238,7 +271,7 @@ void Datalogger::loop()
         // what should we do here?
         // if we are in the field and the manual power cycle got skipped, the battery will quickly drain
         // perhaps just shut down the unit?
-        powerDownSwitchableComponents();
+        powerOffAllPowerDomains();
         while (1)
           ;
       }
@@ -249,7 +282,9 @@ void Datalogger::loop()
     if (shouldExitLoggingMode())
     {
       notify("Should exit logging mode");
+      openFileSystem();
       changeMode(interactive);
+      selectAllSensors(); // some drivers are stopped between their scheduled samples
       return;
     }
 
@@ -258,11 +293,18 @@ void Datalogger::loop()
       return;
     }
 
-    // otherwise go to sleep
-    fileSystemWriteCache->flushCache();
+    writeMemoryStatusIfDue();
+
+    // otherwise go to sleep, rows stay in the write cache while SD writes are batched
+    if (fileSystemOpen)
+    {
+      watchdog_phase_type phase = setWatchdogPhase(watchdog_sd);
+      fileSystemWriteCache->flushCache();
+      setWatchdogPhase(phase);
+    }
   SLEEP:
     stopAndAwaitTrigger();
-    initializeMeasurementCycle();
+    initializeMeasurementCycle(true);
     return;
   }
 
@@ -277,7 +319,11 @@ void Datalogger::loop()
   }
   else if (inMode(interactive))
   {
-    if (interactiveModeLogging)
+    if (sampleStream.active())
+    {
+      streamSamples();
+    }
+    else if (interactiveModeLogging)
     {
       if (timestamp() > lastInteractiveLogTime + 1)
       {
@@ -286,7 +332,7 @@ void Datalogger::loop()
         if(interactiveModeLogging)
         {
           outputLastMeasurement();
-          Serial2.print(F("CMD >> "));
+          SerialOutput.print(F("CMD >> "));
         }
         writeRawMeasurementToLogFile();
         lastInteractiveLogTime = timestamp();
@@ -298,7 +344,7 @@ void Datalogger::loop()
   {
     measureSensorValues(false);
     writeRawMeasurementToLogFile();
-    delay(5000); // this value could be configurable, also a step / read from CLI is possible
+    idle(5000, idle_wfi); // this value could be configurable, also a step / read from CLI is possible
   }
   else
   {
@@ -306,7 +352,7 @@ void Datalogger::loop()
     notify(F("Invalid Mode!"));
     notify(mode);
     mode = interactive;
-    delay(1000);
+    idle(1000, idle_wfi);
   }
 
   powerCycle = false;
@@ -314,85 +360,72 @@ void Datalogger::loop()
 
 void Datalogger::loadSensorConfigurations()
 {
-
-  // load sensor configurations from EEPROM and count them
-  sensorCount = 0;
-  configuration_bytes sensorConfigs[EEPROM_TOTAL_SENSOR_SLOTS];
+  // load sensor configurations from EEPROM and construct the drivers
   for (int i = 0; i < EEPROM_TOTAL_SENSOR_SLOTS; i++)
   {
-    notify("reading slot");
-    readSensorConfigurationFromEEPROM(i, &sensorConfigs[i]);
+    slotDrivers[i] = NULL;
+    sensorRunning[i] = false;
+    sensorDue[i] = false;
 
-    common_sensor_driver_config * commonConfiguration = (common_sensor_driver_config *) &sensorConfigs[i].common;
-
-    notify(commonConfiguration->sensor_type);
-    if( sensorTypeCodeExists(commonConfiguration->sensor_type) )
+    configuration_bytes sensorConfig;
+    if (configurationCached)
     {
-      notify("found configured sensor");
-      sensorCount++;
+      memcpy(&sensorConfig, configurationCache()->sensorConfigurations[i], sizeof(configuration_bytes));
+    }
+    else
+    {
+      readSensorConfigurationFromEEPROM(i, &sensorConfig);
     }
-    commonConfiguration->slot = i;
-  }
-  if (sensorCount == 0)
-  {
-    notify("no sensor configurations found");
-  }
-  notify("FREE MEM");
-  printFreeMemory();
 
-  // construct the drivers
-  notify("construct drivers");
-  drivers = (SensorDriver **)malloc(sizeof(SensorDriver *) * sensorCount);
-  int j = 0;
-  for (int i = 0; i < EEPROM_TOTAL_SENSOR_SLOTS; i++)
-  {
-    notify("FREE MEM");
-    printFreeMemory();
-    common_sensor_driver_config * commonConfiguration = (common_sensor_driver_config *) &sensorConfigs[i].common;
+    common_sensor_driver_config * commonConfiguration = (common_sensor_driver_config *) &sensorConfig.common;
+    commonConfiguration->slot = i;
 
+    LOG_DEBUGF("slot %d sensor type %d", i, commonConfiguration->sensor_type);
     if ( !sensorTypeCodeExists(commonConfiguration->sensor_type) )
     {
-      notify("no sensor with that code");
       continue;
     }
 
-    debug("getting driver for sensor type");
-    debug(commonConfiguration->sensor_type);
     SensorDriver *driver = driverForSensorTypeCode(commonConfiguration->sensor_type);
-    debug("got sensor driver");
-    checkMemory();
+    if (driver == NULL)
+    {
+      notify(F("driver pool full"));
+      continue;
+    }
 
-    drivers[j] = driver;
-    j++;
+    slotDrivers[i] = driver;
 
     if (driver->getProtocol() == i2c)
     {
-      debug("got i2c sensor");
       ((I2CProtocolSensorDriver *)driver)->setWire(&WireTwo);
-      debug("set wire");
     }
-    debug("do setup");
-    driver->setup();
+    driver->configureFromBytes(sensorConfig); //pass configuration struct to the driver
+    LOG_DEBUG(F("configured sensor driver"));
 
-    debug("configure sensor driver");
-    driver->configureFromBytes(sensorConfigs[i]); //pass configuration struct to the driver
-    debug("configured sensor driver");
+    startSensor(driver); // after configuring, setup() uses the configured pins
+    sensorDue[i] = true;
   }
 
+  rebuildDriverList();
+  if (sensorCount == 0)
+  {
+    notify("no sensor configurations found");
+  }
+  notify("FREE MEM");
+  printFreeMemory();
 }
 
 void Datalogger::reloadSensorConfigurations() // for dev & debug
 {
-  // calling this function does not deal with memory fragmentation
-  // so it's not part of the main system, only for dev & debug
+  // drivers come back to the driver pool, so reloading doesn't fragment the heap
   notify("FREE MEM reload");
   printFreeMemory();
   // free sensor configs
   for(unsigned short i=0; i<sensorCount; i++)
   {
-    delete(drivers[i]);
+    stopSensor(drivers[i]);
+    releaseDriver(drivers[i]);
   }
-  free(drivers);
   notify("FREE MEM reload");
   printFreeMemory();
   loadSensorConfigurations();
@@ -409,9 +442,95 @@ void Datalogger::stopLogging()
   interactiveModeLogging = false;
 }
 
+bool Datalogger::startStreaming(unsigned short slotMask)
+{
+  if (slotMask == 0)
+  {
+    for (unsigned short i = 0; i < sensorCount; i++)
+    {
+      slotMask |= 1 << drivers[i]->getSlot();
+    }
+  }
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if ((slotMask & (1 << slot)) && slotDrivers[slot] == NULL)
+    {
+      return false;
+    }
+  }
+  if (slotMask == 0)
+  {
+    return false; // nothing configured
+  }
+
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if (slotMask & (1 << slot))
+    {
+      startSensor(slotDrivers[slot]);
+    }
+    streamMeasuring[slot] = false;
+  }
+  sampleStream.start(slotMask);
+  return true;
+}
+
+void Datalogger::stopStreaming()
+{
+  sampleStream.stop();
+}
+
+unsigned short Datalogger::describeStream(byte * body, unsigned short capacity)
+{
+  return sampleStream.describe(slotDrivers, body, capacity);
+}
+
+void Datalogger::getStreamCounts(uint32 * sent, uint32 * dropped)
+{
+  *sent = sampleStream.sentCount();
+  *dropped = sampleStream.droppedCount();
+}
+
+void Datalogger::streamSamples()
+{
+  // each selected sensor starts its next measurement as soon as the last one is collected
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    SensorDriver * driver = drivers[i];
+    unsigned short slot = driver->getSlot();
+    if (!sampleStream.selected(slot))
+    {
+      continue;
+    }
+
+    if (!streamMeasuring[slot])
+    {
+      // hold each slot until it has warmed up, samples before that aren't valid
+      if (driver->millisecondsUntilWarmedUp(millis() - sensorStartedAt[slot]) > 0 || !driver->isWarmedUp())
+      {
+        continue;
+      }
+      driver->startMeasurement();
+      streamMeasuring[slot] = true;
+    }
+    else if ((long) (millis() - driver->measurementReadyAt()) >= 0)
+    {
+      if (driver->getProtocol() == analog && settings.externalADCEnabled && powerDomainIsOn(POWER_DOMAIN_EXTERNAL_ADC))
+      {
+        externalADC->convertEnabledChannels();
+      }
+      if (driver->collectMeasurement())
+      {
+        sampleStream.send(driver, millis());
+      }
+      streamMeasuring[slot] = false;
+    }
+  }
+}
+
 bool Datalogger::shouldExitLoggingMode()
 {
-  if (Serial2.peek() != -1)
+  if (SerialOutput.peek() != -1)
   {
     //attempt to process the command line
     for (int i = 0; i < 10; i++)
@@ -434,7 +553,7 @@ bool Datalogger::shouldContinueBursting()
 {
   for (unsigned short i = 0; i < sensorCount; i++)
   {
-    if (!drivers[i]->burstCompleted())
+    if (inCurrentBurst(drivers[i]) && !drivers[i]->burstCompleted())
     {
       return true;
     }
@@ -446,7 +565,10 @@ void Datalogger::initializeBurst()
 {
   for (unsigned int i = 0; i < sensorCount; i++)
   {
-    drivers[i]->initializeBurst();
+    if (inCurrentBurst(drivers[i]))
+    {
+      drivers[i]->initializeBurst();
+    }
   }
 }
 
@@ -456,15 +578,38 @@ void Datalogger::initializeBurst()
 // }
 
 
-void Datalogger::initializeMeasurementCycle()
+void Datalogger::initializeMeasurementCycle(bool scheduled)
 {
   // notify(F("setting base time"));
-  currentEpoch = timestamp();
-  offsetMillis = millis();
 
-  initializeBurst();
+  if (scheduled)
+  {
+    // only the slots whose deadline has arrived take part in this cycle
+    // deadlines follow the internal RTC counter that the wake alarms are set from
+    time_t scheduleEpoch = timestamp();
+    for (unsigned short i = 0; i < sensorCount; i++)
+    {
+      unsigned short slot = drivers[i]->getSlot();
+      sensorDue[slot] = scheduler.isDue(slot, scheduleEpoch);
+      burstsRemaining[slot] = 0;
+      if (sensorDue[slot])
+      {
+        scheduler.advance(slot, scheduleEpoch);
+        startSensor(drivers[i]);
+        burstsRemaining[slot] = burstNumberForSensor(drivers[i]);
+      }
+    }
+    if (sensorCount > 0 && !sensorsDue())
+    {
+      return;
+    }
+  }
+  else
+  {
+    selectAllSensors();
+  }
 
-  completedBursts = 0;
+  initializeBurst();
 
   if (settings.startUpDelay > 0)
   {
@@ -473,70 +618,117 @@ void Datalogger::initializeMeasurementCycle()
     // delay(20000);
     // startCustomWatchDog();
 
-    notify(F("wait for start up delay"));
-    int startUpDelay = settings.startUpDelay*60; // convert to seconds and print
+    int startUpDelay = settings.startUpDelay*60; // convert to seconds
     // startUpDelay = 2;
-    notify(startUpDelay);
-    sleepMCU(startUpDelay * 1000); // convert seconds to milliseconds
-    notify("sleep done");
+    LOG_DEBUGF("wait for start up delay %d s", startUpDelay);
+    idle(startUpDelay * 1000); // convert seconds to milliseconds
   }
 
-  bool sensorsWarmedUp = false;
-  while(sensorsWarmedUp == false)
+  // sleep through warm up, waking as each sensor is expected to be ready
+  unsigned int warmUpMilliseconds = millisecondsUntilSensorsWarmedUp();
+  while (warmUpMilliseconds > 0)
   {
-    sensorsWarmedUp = true;
-    for (unsigned short i = 0; i < sensorCount; i++)
-    {
-      notify("check isWarmed");
-      if (!drivers[i]->isWarmedUp())
-      {
-        // TODO: enhancement, ask the sensor driver if we should sleep MCU for a while
-        // mcuSleep(drivers[i]->warmUpSleep());
-        sensorsWarmedUp = false;
-      }
-    }
+    LOG_DEBUGF("sleep for warm up %u ms", warmUpMilliseconds);
+    idle(warmUpMilliseconds);
+    warmUpMilliseconds = millisecondsUntilSensorsWarmedUp();
   }
 
 }
 
 void Datalogger::measureSensorValues(bool performingBurst)
 {
-  if (settings.externalADCEnabled)
+  trace(trace_measure, sensorCount);
+  bool analogSensorDue = false;
+  for (unsigned int i = 0; i < sensorCount; i++)
+  {
+    if ((!performingBurst || inCurrentBurst(drivers[i])) && drivers[i]->getProtocol() == analog)
+    {
+      analogSensorDue = true;
+    }
+  }
+
+  if (settings.externalADCEnabled && analogSensorDue && powerDomainIsOn(POWER_DOMAIN_EXTERNAL_ADC))
   {
     // get readings from the external ADC
-    debug("converting enabled channels call");
     externalADC->convertEnabledChannels();
-    debug("converted enabled channels");
   }
 
+  // start every conversion first so slow sensors convert in parallel
+  bool pending[EEPROM_TOTAL_SENSOR_SLOTS];
+  unsigned short pendingCount = 0;
   for (unsigned int i = 0; i < sensorCount; i++)
   {
-    if (drivers[i]->takeMeasurement())
+    pending[i] = !performingBurst || (inCurrentBurst(drivers[i]) && !drivers[i]->burstCompleted());
+    if (pending[i])
+    {
+      drivers[i]->startMeasurement();
+      pendingCount++;
+    }
+  }
+
+  // then collect them in the order they become ready, sleeping in between
+  bool rowSampled = false;
+  while (pendingCount > 0)
+  {
+    short next = -1;
+    for (unsigned int i = 0; i < sensorCount; i++)
+    {
+      if (pending[i] && (next == -1 || (long) (drivers[i]->measurementReadyAt() - drivers[next]->measurementReadyAt()) < 0))
+      {
+        next = i;
+      }
+    }
+
+    long untilReady = (long) (drivers[next]->measurementReadyAt() - millis());
+    if (untilReady > 0)
     {
+      idle(untilReady);
+    }
+
+    if (drivers[next]->collectMeasurement())
+    {
+      sampleCapturedAt[drivers[next]->getSlot()] = internalRTCTicks();
+      if (!rowSampled)
+      {
+        rowSampleTicks = sampleCapturedAt[drivers[next]->getSlot()]; // first sample of the row
+        rowSampled = true;
+      }
       if (performingBurst)
       {
-        drivers[i]->incrementBurst(); // burst bookkeeping
+        drivers[next]->incrementBurst(); // burst bookkeeping
       }
     }
+    pending[next] = false;
+    pendingCount--;
+  }
+  if (!rowSampled)
+  {
+    rowSampleTicks = internalRTCTicks();
+  }
+
+  if (wakeTiming.inProgress())
+  {
+    wakeTiming.mark(wake_phase_first_sample, rowSampleTicks);
+    writeWakeTiming();
   }
 }
 
-void Datalogger::writeStatusFieldsToLogFile(const char * type)
+void Datalogger::writeStatusFieldsToLogFile(const char * type, uint32 sampleTicks)
 {
   // debug(F("Write status fields"));
 
   fileSystemWriteCache->writeString(type);
   fileSystemWriteCache->writeString((char *)",");
 
-  // Fetch and Log time from DS3231 RTC as epoch and human readable timestamps
-  uint32 currentMillis = millis();
-
-  double currentTime = (double) currentEpoch + ( (double) ( currentMillis - offsetMillis) ) / 1000;
+  // Log the time the sample was taken, from the RTC counter, as epoch and human readable timestamps
+  time_t sampleEpoch;
+  unsigned short sampleMilliseconds;
+  clockTimeForTicks(sampleTicks, &sampleEpoch, &sampleMilliseconds);
 
   char currentTimeString[20];
   char humanTimeString[24]; // YYYY-MM-DD HH:MM:SS:sss
-  sprintf(currentTimeString, "%10.3f", currentTime);                  // convert double value into string
-  t_t2ts(currentTime, currentMillis - offsetMillis, humanTimeString); // convert time_t value to human readable timestamp
+  sprintf(currentTimeString, "%lu.%03u", (unsigned long) sampleEpoch, sampleMilliseconds);
+  t_t2ts(sampleEpoch, sampleMilliseconds, humanTimeString); // convert time_t value to human readable timestamp
 
   fileSystemWriteCache->writeString(settings.siteName);
   fileSystemWriteCache->writeString((char *)",");
@@ -552,10 +744,7 @@ void Datalogger::writeStatusFieldsToLogFile(const char * type)
   {
     char deploymentIdentifier[16] = {0};
     strncpy(deploymentIdentifier, settings.deploymentIdentifier, 15);
-    debug(deploymentIdentifier[0]);
-    debug(deploymentIdentifier);
-    debug(uuidString);
-    debug(settings.deploymentTimestamp);
+    LOG_DEBUGF("deployment %s %s %lu", deploymentIdentifier, uuidString, settings.deploymentTimestamp);
     sprintf(buffer, "%s-%s-%lu", deploymentIdentifier, uuidString, settings.deploymentTimestamp);
   }
   fileSystemWriteCache->writeString(buffer);
@@ -570,7 +759,8 @@ void Datalogger::writeStatusFieldsToLogFile(const char * type)
   fileSystemWriteCache->writeString((char *)","); 
 
   // write out the raw battery reading
-  sprintf(buffer, "%d,", getBatteryValue());
+  unsigned short batteryMillivolts = battery.readMillivolts();
+  sprintf(buffer, "%u.%03u,%u,", batteryMillivolts / 1000, batteryMillivolts % 1000, battery.getTier());
   fileSystemWriteCache->writeString(buffer);
 }
 
@@ -588,15 +778,22 @@ void Datalogger::writeUserFieldsToLogFile()
 
 bool Datalogger::writeRawMeasurementToLogFile()
 {
-  writeStatusFieldsToLogFile("raw");
+  writeStatusFieldsToLogFile("raw", rowSampleTicks); // when the row was sampled, not when it is written
 
   // and write out the sensor data
-  debug(F("Write sensor data"));
+  LOG_DEBUG(F("Write sensor data"));
   for (unsigned short i = 0; i < sensorCount; i++)
   {
     // get values from the sensors
-    const char *dataString = drivers[i]->getRawDataString();
-    fileSystemWriteCache->writeString(dataString);
+    if (inCurrentBurst(drivers[i]))
+    {
+      const char *dataString = drivers[i]->getRawDataString();
+      fileSystemWriteCache->writeString(dataString);
+    }
+    else
+    {
+      writeEmptyColumns(drivers[i]);
+    }
     if (i < sensorCount - 1)
     {
       fileSystemWriteCache->writeString((char *)reinterpretCharPtr(F(",")));
@@ -608,16 +805,53 @@ bool Datalogger::writeRawMeasurementToLogFile()
   return true;
 }
 
+void Datalogger::writeWakeTiming()
+{
+  // a data file row like the other status rows, nothing reads the console in the field
+  char record[WAKE_TIMING_RECORD_LENGTH];
+  if (!wakeTiming.report(record, sizeof(record)))
+  {
+    return;
+  }
+  notify(record);
+  writeStatusFieldsToLogFile("wake", internalRTCTicks());
+  fileSystemWriteCache->writeString(record);
+  fileSystemWriteCache->endOfLine();
+}
+
+void Datalogger::writeMemoryStatusIfDue()
+{
+  time_t now = timestamp();
+  if (now < nextMemoryStatusTime)
+  {
+    return;
+  }
+  nextMemoryStatusTime = now + MEMORY_STATUS_INTERVAL_SECONDS;
+
+  char memoryStatus[MEMORY_STATUS_LENGTH];
+  formatMemoryStatistics(memoryStatus, sizeof(memoryStatus));
+  writeStatusFieldsToLogFile("memory", internalRTCTicks());
+  fileSystemWriteCache->writeString(memoryStatus);
+  fileSystemWriteCache->endOfLine();
+}
+
 bool Datalogger::writeSummaryMeasurementToLogFile()
 {
-  writeStatusFieldsToLogFile("summary");
+  writeStatusFieldsToLogFile("summary", internalRTCTicks());
 
   // and write out the sensor data
   for (unsigned short i = 0; i < sensorCount; i++)
   {
     // get values from the sensors
-    const char *dataString = drivers[i]->getSummaryDataString();
-    fileSystemWriteCache->writeString(dataString);
+    if (inCurrentBurst(drivers[i]))
+    {
+      const char *dataString = drivers[i]->getSummaryDataString();
+      fileSystemWriteCache->writeString(dataString);
+    }
+    else
+    {
+      writeEmptyColumns(drivers[i]);
+    }
     if (i < sensorCount - 1)
     {
       fileSystemWriteCache->writeString((char *)reinterpretCharPtr(F(",")));
@@ -632,13 +866,16 @@ bool Datalogger::writeSummaryMeasurementToLogFile()
 
 void Datalogger::setUpCLI()
 {
-  cli = CommandInterface::create(Serial2, this);
+  cli = CommandInterface::create(SerialOutput, this);
   cli->setup();
 }
 
 void Datalogger::processCLI()
 {
   cli->poll();
+
+  // coalesce settings changes made by the command into one EEPROM update
+  commitDataloggerConfiguration();
 }
 
 
@@ -649,91 +886,113 @@ void Datalogger::storeSensorConfigurationIfNeedsSave()
     if(drivers[i]->getNeedsSave())
     {
       storeSensorConfiguration(drivers[i]);
+      drivers[i]->clearConfigurationNeedsSave();
     }
 
   }
 }
 
-void Datalogger::setConfiguration(cJSON *config)
+bool Datalogger::setConfiguration(JSONReader &config)
 {
-  const cJSON* siteNameJSON = cJSON_GetObjectItemCaseSensitive(config, "siteName");
-  if(siteNameJSON != NULL && cJSON_IsString(siteNameJSON) && strlen(siteNameJSON->valuestring) <= 7)
+  bool valid = true;
+
+  if(!config.getString("siteName", settings.siteName, sizeof(settings.siteName))) // 7 characters
   {
-    strcpy(settings.siteName, siteNameJSON->valuestring);
-  } else {
     notify("Invalid site name");
+    valid = false;
   }
 
-  const cJSON* loggerNameJSON = cJSON_GetObjectItemCaseSensitive(config, "loggerName");
-  if(loggerNameJSON != NULL && cJSON_IsString(loggerNameJSON) && strlen(loggerNameJSON->valuestring) <= 7)
+  if(!config.getString("loggerName", settings.loggerName, sizeof(settings.loggerName))) // 7 characters
   {
-    strcpy(settings.loggerName, loggerNameJSON->valuestring);
-  } else {
     notify("Invalid logger name");
+    valid = false;
   }
-  
-  const cJSON* deploymentIdentifierJSON = cJSON_GetObjectItemCaseSensitive(config, "deploymentIdentifier");
-  if(deploymentIdentifierJSON != NULL && cJSON_IsString(deploymentIdentifierJSON) && strlen(deploymentIdentifierJSON->valuestring) <= 15)
+
+  if(!config.getString("deploymentIdentifier", settings.deploymentIdentifier, sizeof(settings.deploymentIdentifier))) // 15 characters
   {
-    strcpy(settings.deploymentIdentifier, deploymentIdentifierJSON->valuestring);
-  } else {
     notify("Invalid deployment identifier");
+    valid = false;
   }
 
-  const cJSON * intervalJson = cJSON_GetObjectItemCaseSensitive(config, "interval");
-  if(intervalJson != NULL && cJSON_IsNumber(intervalJson) && intervalJson->valueint > 0)
+  long interval;
+  if(config.getInteger("interval", &interval) && interval > 0)
   {
-    settings.interval = (byte) intervalJson->valueint;
+    settings.interval = (byte) interval;
   } else {
     notify("Invalid interval");
+    valid = false;
   }
 
-  const cJSON * burstNumberJson = cJSON_GetObjectItemCaseSensitive(config, "burstNumber");
-  if(burstNumberJson != NULL && cJSON_IsNumber(burstNumberJson) && burstNumberJson->valueint > 0)
+  long burstNumber;
+  if(config.getInteger("burstNumber", &burstNumber) && burstNumber > 0)
   {
-    settings.burstNumber = (byte) burstNumberJson->valueint;
+    settings.burstNumber = (byte) burstNumber;
   } else {
     notify("Invalid burst number");
+    valid = false;
   }
 
-  const cJSON * startUpDelayJson = cJSON_GetObjectItemCaseSensitive(config, "startUpDelay");
-  if(startUpDelayJson != NULL && cJSON_IsNumber(startUpDelayJson) && startUpDelayJson->valueint >= 0)
+  long startUpDelay;
+  if(config.getInteger("startUpDelay", &startUpDelay) && startUpDelay >= 0)
   {
-    settings.startUpDelay = (byte) startUpDelayJson->valueint;
+    settings.startUpDelay = (byte) startUpDelay;
   } else {
     notify("Invalid start up delay");
+    valid = false;
   }
 
-  const cJSON * interBurstDelayJson = cJSON_GetObjectItemCaseSensitive(config, "interBurstDelay");
-  if(interBurstDelayJson != NULL && cJSON_IsNumber(interBurstDelayJson) && interBurstDelayJson->valueint >= 0)
+  long interBurstDelay;
+  if(config.getInteger("interBurstDelay", &interBurstDelay) && interBurstDelay >= 0)
   {
-    settings.interBurstDelay = (byte) interBurstDelayJson->valueint;
+    settings.interBurstDelay = (byte) interBurstDelay;
   } else {
     notify("Invalid inter burst delay");
+    valid = false;
   }
 
   storeDataloggerConfiguration();
+  return valid;
 }
 
-// TODO: can I modify this to return a JSON instead? It can then be used when writing the comments before the header in the csv
 void Datalogger::getConfiguration(datalogger_settings_type *dataloggerSettings)
 {
   memcpy(dataloggerSettings, &settings, sizeof(datalogger_settings_type));
+}
 
-  // cJSON* json = cJSON_CreateObject();
-  // cJSON_AddStringToObject(json, reinterpretCharPtr(F("device_uuid")), this->datalogger->getUUIDString());
-  // cJSON_AddStringToObject(json, reinterpretCharPtr(F("site_name")), dataloggerSettings.siteName);
-  // cJSON_AddStringToObject(json, reinterpretCharPtr(F("logger_name")), dataloggerSettings.loggerName);
-  // cJSON_AddStringToObject(json, reinterpretCharPtr(F("deployment_identifier")), dataloggerSettings.deploymentIdentifier);
-  // cJSON_AddNumberToObject(json, reinterpretCharPtr(F("interval(min)")), dataloggerSettings.interval);
-  // cJSON_AddNumberToObject(json, reinterpretCharPtr(F("burst_number")), dataloggerSettings.burstNumber);
-  // cJSON_AddNumberToObject(json, reinterpretCharPtr(F("start_up_delay(min)")), dataloggerSettings.startUpDelay);
-  // cJSON_AddNumberToObject(json, reinterpretCharPtr(F("burst_delay(min)")), dataloggerSettings.interBurstDelay);
-  // return(json)
+void Datalogger::getConfigurationJSON(JSONWriter &json)
+{
+  json.addString(reinterpretCharPtr(F("device_uuid")), getUUIDString());
+  json.addString(reinterpretCharPtr(F("site_name")), settings.siteName);
+  json.addString(reinterpretCharPtr(F("logger_name")), settings.loggerName);
+  json.addString(reinterpretCharPtr(F("deployment_identifier")), settings.deploymentIdentifier);
+  json.addInteger(reinterpretCharPtr(F("interval(min)")), settings.interval);
+  json.addInteger(reinterpretCharPtr(F("burst_number")), settings.burstNumber);
+  json.addInteger(reinterpretCharPtr(F("start_up_delay(min)")), settings.startUpDelay);
+  json.addInteger(reinterpretCharPtr(F("burst_delay(min)")), settings.interBurstDelay);
+  json.addInteger(reinterpretCharPtr(F("battery_full_scale(mV)")), settings.batteryFullScaleMillivolts);
+  int batteryTiers[BATTERY_TIER_COUNT];
+  for(unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    batteryTiers[i] = settings.batteryTierDecivolts[i] * 100;
+  }
+  json.addIntegerArray(reinterpretCharPtr(F("battery_tiers(mV)")), batteryTiers, BATTERY_TIER_COUNT);
 }
 
-void Datalogger::setSensorConfiguration(char *type, cJSON *json)
+bool Datalogger::setSensorConfiguration(JSONReader &json)
 {
+  long slot;
+  if(!json.getInteger("slot", &slot) || slot > EEPROM_TOTAL_SENSOR_SLOTS || slot < 1)
+  {
+    notify(F("Invalid slot"));
+    return false;
+  }
+
+  char type[30];
+  if(!json.getString("type", type, sizeof(type)))
+  {
+    notify(F("Invalid type"));
+    return false;
+  }
 
   SensorDriver *driver = NULL;
   short typeCode = typeCodeForSensorTypeString(type);
@@ -743,70 +1002,46 @@ void Datalogger::setSensorConfiguration(char *type, cJSON *json)
   {
     if (driver->configureFromJSON(json) == false)
     {
-      return;
+      releaseDriver(driver);
+      return false;
     }
     if (driver->getProtocol() == i2c)
     {
       ((I2CProtocolSensorDriver *)driver)->setWire(&WireTwo);
     }
-    driver->setup();
     storeSensorConfiguration(driver);
 
-    bool slotReplacement = false;
-    for (unsigned short i = 0; i < sensorCount; i++)
+    unsigned short slot = driver->getSlot();
+    SensorDriver *replacedDriver = slotDrivers[slot];
+    if (replacedDriver != NULL)
     {
-      if (drivers[i]->getCommonConfigurations()->slot == driver->getCommonConfigurations()->slot)
-      {
-        slotReplacement = true;
-        SensorDriver *replacedDriver = drivers[i];
-        drivers[i] = driver;
-        delete (replacedDriver);
-        break;
-      }
+      stopSensor(replacedDriver);
     }
-    if (!slotReplacement)
+    slotDrivers[slot] = driver;
+    startSensor(driver);
+    sensorDue[slot] = true;
+    burstsRemaining[slot] = burstNumberForSensor(driver);
+    if (replacedDriver != NULL)
     {
-      sensorCount = sensorCount + 1;
-      SensorDriver **updatedDrivers = (SensorDriver **)malloc(sizeof(SensorDriver *) * sensorCount);
-      unsigned short i = 0;
-      // printFreeMemory();
-      // if(sensorCount > 1)
-      // {
-      //   notify(drivers[i]->getCommonConfigurations()->slot);
-      //   notify(driver->getCommonConfigurations()->slot);
-      // }
-      for (; i < sensorCount-1 && drivers[i]->getCommonConfigurations()->slot < driver->getCommonConfigurations()->slot ; i++)
-      {
-        updatedDrivers[i] = drivers[i];
-      }
-
-      updatedDrivers[i] = driver;
-      i++;
-      for (; i < sensorCount; i++)
-      {
-        updatedDrivers[i] = drivers[i-1];
-      }
-      free(drivers);
-      drivers = updatedDrivers;
+      releaseDriver(replacedDriver);
     }
+    rebuildDriverList();
+    return true;
+  }
+  else if (sensorTypeCodeExists(typeCode))
+  {
+    notify(F("driver pool full"));
   }
+  return false;
 }
 
-void Datalogger::clearSlot(unsigned short slot)
+bool Datalogger::clearSlot(unsigned short slot)
 {
-  bool slotConfigured = false;
-  for (unsigned short i = 0; i < sensorCount; i++)
-  {
-    if (drivers[i]->getCommonConfigurations()->slot == slot)
-    {
-      slotConfigured = true;
-      break;
-    }
-  }
-  if (!slotConfigured)
+  SensorDriver *driver = getDriver(slot);
+  if (driver == NULL)
   {
     notify("Slot not configured");
-    return;
+    return false;
   }
 
   byte empty[SENSOR_CONFIGURATION_SIZE];
@@ -815,29 +1050,20 @@ void Datalogger::clearSlot(unsigned short slot)
     empty[i] = 0xFF;
   }
   writeSensorConfigurationToEEPROM(slot, empty);
-  sensorCount--;
-
-  SensorDriver **updatedDrivers = (SensorDriver **)malloc(sizeof(SensorDriver *) * sensorCount);
-  int j = 0;
-  for (unsigned short i = 0; i < sensorCount + 1; i++)
-  {
-    if (this->drivers[i]->getCommonConfigurations()->slot != slot)
-    {
-      updatedDrivers[j] = this->drivers[i];
-      j++;
-    } 
-    else 
-    {
-      delete(this->drivers[i]);
-    }
-  }
-  free(this->drivers);
-  this->drivers = updatedDrivers;
+  sensorConfigurationChanged();
+
+  stopSensor(driver);
+  slotDrivers[slot] = NULL;
+  sensorDue[slot] = false;
+  scheduler.removeSchedule(slot);
+  releaseDriver(driver);
+  rebuildDriverList();
+  return true;
 }
 
-cJSON *Datalogger::getSensorConfiguration(short index) // returns unprotected **
+void Datalogger::getSensorConfiguration(short index, JSONWriter &json)
 {
-  return drivers[index]->getConfigurationJSON();
+  drivers[index]->getConfigurationJSON(json);
 }
 
 void Datalogger::setInterval(int interval)
@@ -869,6 +1095,62 @@ void Datalogger::setExternalADCEnabled(bool enabled)
   settings.externalADCEnabled = enabled;
 }
 
+void Datalogger::calibrateBattery(unsigned short measuredMillivolts)
+{
+  // scale the divider so the current reading matches a voltage measured at the terminals
+  int reading = getBatteryValue();
+  if (reading <= 0)
+  {
+    notify(F("No battery reading"));
+    return;
+  }
+  unsigned long fullScaleMillivolts = (unsigned long) measuredMillivolts * BATTERY_ADC_COUNTS / reading;
+  if (fullScaleMillivolts > 65535)
+  {
+    notify(F("Battery calibration out of range"));
+    return;
+  }
+  settings.batteryFullScaleMillivolts = fullScaleMillivolts;
+  storeDataloggerConfiguration();
+  configureBatteryPolicy();
+}
+
+void Datalogger::setBatteryTiers(unsigned short *tierMillivolts)
+{
+  for (unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    unsigned short decivolts = tierMillivolts[i] / 100;
+    settings.batteryTierDecivolts[i] = decivolts > 254 ? 254 : decivolts;
+  }
+  storeDataloggerConfiguration();
+  configureBatteryPolicy();
+}
+
+void Datalogger::configureBatteryPolicy()
+{
+  unsigned short tierMillivolts[BATTERY_TIER_COUNT];
+  for (unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    tierMillivolts[i] = settings.batteryTierDecivolts[i] * 100;
+  }
+  battery.configure(settings.batteryFullScaleMillivolts, tierMillivolts);
+}
+
+void Datalogger::updateBatteryPolicy()
+{
+  if (battery.update())
+  {
+    trace(trace_battery_tier, battery.getTier());
+    notify(F("Battery tier"));
+    notify(battery.getTier());
+    notify(battery.getTrendMillivolts());
+    if (inMode(logging))
+    {
+      scheduleSensors(); // the tier changes the sampling intervals
+    }
+  }
+}
+
 void Datalogger::setUserNote(char *note)
 {
   strcpy(userNote, note);
@@ -882,20 +1164,238 @@ void Datalogger::setUserValue(int value)
 void Datalogger::toggleTraceValues()
 {
   settings.debug_values = !settings.debug_values;
-  storeConfiguration();
-  Serial2.println(bool(settings.debug_values));
+  storeDataloggerConfiguration();
+  SerialOutput.println(bool(settings.debug_values));
 }
 
 SensorDriver *Datalogger::getDriver(unsigned short slot)
+{
+  if (slot >= EEPROM_TOTAL_SENSOR_SLOTS)
+  {
+    return NULL;
+  }
+  return slotDrivers[slot];
+}
+
+void Datalogger::rebuildDriverList()
+{
+  // drivers holds the configured slots in slot order for iterating during measurement and output
+  sensorCount = 0;
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if (slotDrivers[slot] != NULL)
+    {
+      drivers[sensorCount] = slotDrivers[slot];
+      sensorCount++;
+    }
+  }
+}
+
+void Datalogger::scheduleSensors()
+{
+  // slots without their own interval follow the datalogger interval
+  scheduler.clear();
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    const common_sensor_driver_config * common = drivers[i]->getCommonConfigurations();
+    unsigned long interval = common->interval > 0 ? common->interval : (unsigned long) settings.interval * 60;
+    interval *= battery.intervalMultiplier();
+    scheduler.setSchedule(common->slot, interval, common->offset);
+  }
+  scheduler.start(timestamp());
+}
+
+void Datalogger::selectAllSensors()
+{
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    unsigned short slot = drivers[i]->getSlot();
+    startSensor(drivers[i]);
+    sensorDue[slot] = true;
+    burstsRemaining[slot] = burstNumberForSensor(drivers[i]);
+  }
+}
+
+bool Datalogger::sensorsDue()
+{
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    if (inCurrentBurst(drivers[i]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Datalogger::inCurrentBurst(SensorDriver *driver)
+{
+  unsigned short slot = driver->getSlot();
+  return sensorDue[slot] && burstsRemaining[slot] > 0;
+}
+
+unsigned short Datalogger::burstNumberForSensor(SensorDriver *driver)
+{
+  if (battery.singleBurst())
+  {
+    return 1;
+  }
+  byte burstNumber = driver->getCommonConfigurations()->burst_number;
+  return burstNumber > 0 ? burstNumber : settings.burstNumber;
+}
+
+void Datalogger::startSensor(SensorDriver *driver)
+{
+  unsigned short slot = driver->getSlot();
+  if (!sensorRunning[slot])
+  {
+    sensorPowerDomains[slot] = driver->getPowerDomains();
+    acquirePowerDomains(sensorPowerDomains[slot]);
+    driver->setup();
+    sensorRunning[slot] = true;
+    sensorStartedAt[slot] = millis();
+  }
+}
+
+void Datalogger::startScheduledSensors(time_t wakeTime)
+{
+  // start warm up for the slots due at this wake before the slower setup work
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    if (scheduler.isDue(drivers[i]->getSlot(), wakeTime))
+    {
+      startSensor(drivers[i]);
+    }
+  }
+}
+
+unsigned short Datalogger::powerDomainsForScheduledSensors(time_t wakeTime)
+{
+  unsigned short domains = 0;
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    if (scheduler.isDue(drivers[i]->getSlot(), wakeTime))
+    {
+      domains |= drivers[i]->getPowerDomains();
+    }
+  }
+  return domains;
+}
+
+unsigned int Datalogger::millisecondsUntilSensorsWarmedUp()
+{
+  // shortest remaining warm up of the sensors that are not ready yet, 0 when all are ready
+  unsigned int shortest = 0;
+  uint32 now = millis();
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    if (!inCurrentBurst(drivers[i]))
+    {
+      continue;
+    }
+    unsigned short slot = drivers[i]->getSlot();
+    unsigned int remaining = drivers[i]->millisecondsUntilWarmedUp(now - sensorStartedAt[slot]);
+    if (remaining == 0 && !drivers[i]->isWarmedUp())
+    {
+      remaining = WARM_UP_POLL_MILLISECONDS; // the driver can't tell, check again shortly
+    }
+    if (remaining > 0 && (shortest == 0 || remaining < shortest))
+    {
+      shortest = remaining;
+    }
+  }
+  return shortest;
+}
+
+void Datalogger::stopSensor(SensorDriver *driver)
+{
+  unsigned short slot = driver->getSlot();
+  if (sensorRunning[slot])
+  {
+    driver->stop();
+    releasePowerDomains(sensorPowerDomains[slot]);
+    sensorRunning[slot] = false;
+    sensorHibernating[slot] = false;
+  }
+}
+
+void Datalogger::sleepWithSensorsInStandby(uint32 milliseconds)
+{
+  // hibernate the sensors that save power over this gap, then wake each one
+  // its own wake latency before the gap ends, the slowest first
+  uint32 sleepStarted = millis();
+  placeSensorsInStandbyMode(milliseconds);
+
+  while (millis() - sleepStarted < milliseconds)
+  {
+    uint32 remaining = milliseconds - (millis() - sleepStarted);
+
+    short next = -1;
+    for (unsigned short i = 0; i < sensorCount; i++)
+    {
+      if (sensorHibernating[drivers[i]->getSlot()] && (next == -1 || drivers[i]->wakeLatencyMilliseconds() > drivers[next]->wakeLatencyMilliseconds()))
+      {
+        next = i;
+      }
+    }
+
+    if (next == -1)
+    {
+      idle(remaining);
+      break;
+    }
+
+    unsigned int wakeLatency = drivers[next]->wakeLatencyMilliseconds();
+    if (wakeLatency >= remaining)
+    {
+      drivers[next]->wake();
+      sensorHibernating[drivers[next]->getSlot()] = false;
+      continue;
+    }
+    idle(remaining - wakeLatency);
+  }
+
+  wakeSensorsFromStandbyMode();
+}
+
+void Datalogger::placeSensorsInStandbyMode(uint32 milliseconds)
 {
   for (unsigned short i = 0; i < sensorCount; i++)
   {
-    if (this->drivers[i]->getCommonConfigurations()->slot == slot)
+    unsigned short slot = drivers[i]->getSlot();
+    unsigned int breakEven = drivers[i]->hibernateBreakEvenMilliseconds();
+    if (inCurrentBurst(drivers[i]) && sensorRunning[slot] && !sensorHibernating[slot] && breakEven > 0 && milliseconds >= breakEven)
     {
-      return this->drivers[i];
+      drivers[i]->hibernate();
+      sensorHibernating[slot] = true;
+    }
+  }
+}
+
+void Datalogger::wakeSensorsFromStandbyMode()
+{
+  for (unsigned short i = 0; i < sensorCount; i++)
+  {
+    unsigned short slot = drivers[i]->getSlot();
+    if (sensorHibernating[slot])
+    {
+      drivers[i]->wake();
+      sensorHibernating[slot] = false;
+    }
+  }
+}
+
+void Datalogger::writeEmptyColumns(SensorDriver *driver)
+{
+  // keep the csv columns aligned for slots that were not sampled
+  const char *columnHeaders = driver->getCSVColumnHeaders();
+  for (unsigned short i = 0; columnHeaders[i] != '\0'; i++)
+  {
+    if (columnHeaders[i] == ',')
+    {
+      fileSystemWriteCache->writeString((char *)",");
     }
   }
-  return NULL;
 }
 
 void Datalogger::calibrate(unsigned short slot, char *subcommand, int arg_cnt, char **args)
@@ -945,6 +1445,8 @@ void Datalogger::changeMode(mode_type mode)
   sprintf(message, reinterpret_cast<const char *> F("Moving to mode %d"), mode);
   notify(message);
   this->mode = mode;
+  setIdleDepthLimit(mode == logging ? idle_stop : idle_wfi); // stop mode silences the serial port
+  sampleStream.stop(); // streaming is an interactive mode bench tool
 }
 
 bool Datalogger::inMode(mode_type mode)
@@ -971,11 +1473,13 @@ bool Datalogger::deploy()
 bool Datalogger::enterFieldLoggingMode()
 {
   strcpy(loggingFolder, settings.siteName);
-  fileSystem->closeFileSystem();
+  closeFileSystem();
   initializeFilesystem();
   setSensorDebugModes(false);
   changeMode(logging);
   storeMode(logging);
+  refreshConfigurationCache(); // so resets in the field boot from the cache
+  scheduleSensors();
   return true;
 }
 
@@ -983,7 +1487,9 @@ void Datalogger::initializeFilesystem()
 {
   SdFile::dateTimeCallback(dateTime);
 
+  acquirePowerDomains(POWER_DOMAIN_SD);
   fileSystem = new WaterBear_FileSystem(loggingFolder, SD_ENABLE_PIN);
+  fileSystemOpen = true;
   Monitor::instance()->filesystem = fileSystem;
   debug(F("Filesystem started OK"));
 
@@ -992,76 +1498,90 @@ void Datalogger::initializeFilesystem()
   sprintf(setupTS, "unixtime: %lld", setupTime);
   notify(setupTS);
 
-  char header[200];
-  const char *statusFields = "type,site,logger,deployment,deployed_at,uuid,time.s,time.h,battery.V";
+  char header[CSV_HEADER_LENGTH];
+  const char *statusFields = "type,site,logger,deployment,deployed_at,uuid,time.s,time.h,battery.V,battery.tier";
   strcpy(header, statusFields);
-  debug(header);
+  LOG_DEBUG(header);
   for (unsigned short i = 0; i < sensorCount; i++)
   {
-    debug(i);
-    debug(drivers[i]->getCSVColumnHeaders());
+    LOG_DEBUG(i);
+    LOG_DEBUG(drivers[i]->getCSVColumnHeaders());
     strcat(header, ",");
     strcat(header, drivers[i]->getCSVColumnHeaders());
   }
   strcat(header, ",user_note,user_value");
 
   fileSystem->setNewDataFile(setupTime, header); // name file via epoch timestamps
+  reportTrace(fileSystem); // what led up to the last reset, first boot only
 
   if (fileSystemWriteCache != NULL)
   {
     delete (fileSystemWriteCache);
   }
   fileSystemWriteCache = new WriteCache(fileSystem);
+  fileSystemWriteCache->setFlushHandler(openFileSystemForFlush, this);
 }
 
-void Datalogger::powerUpSwitchableComponents()
+bool Datalogger::listFiles(const char * path, directory_visitor visitor, void * context)
 {
-  cycleSwitchablePower();
+  openFileSystem();
+  return fileSystem->listDirectory(path, visitor, context);
+}
 
-  // turn on 5v booster for exADC reference voltage, needs the delay
-  // might be possible to turn off after exADC discovered, not certain.
-  gpioPinOn(GPIO_PIN_3);
-  
-  delay(250);
-  enableI2C1();
-  enableI2C2();
-
-  debug("reset exADC");
-  // Reset external ADC (if it's installed)
-  delay(1); // delay > 50ns before applying ADC reset
-  digitalWrite(EXADC_RESET,LOW); // reset is active low
-  delay(1); // delay > 10ns after starting ADC reset
-  digitalWrite(EXADC_RESET,HIGH);
-  delay(100); // Wait for ADC to start up
-
-  bool externalADCInstalled = scanIC2(&Wire, 0x2f); // use datalogger setting once method is moved to instance method
-  if (externalADCInstalled)
+int Datalogger::readFile(const char * path, uint32 offset, void * buffer, unsigned short length)
+{
+  openFileSystem();
+  return fileSystem->readFile(path, offset, buffer, length);
+}
+
+void Datalogger::openFileSystem()
+{
+  if (!fileSystemOpen)
   {
-    debug(F("Set up extADC"));
-    externalADC = new AD7091R();
-    externalADC->configure();
-    externalADC->enableChannel(0);
-    externalADC->enableChannel(1);
-    externalADC->enableChannel(2);
-    externalADC->enableChannel(3);
+    watchdog_phase_type phase = setWatchdogPhase(watchdog_sd);
+    acquirePowerDomains(POWER_DOMAIN_SD);
+    trace(trace_filesystem_open);
+    fileSystem->reopenFileSystem();
+    fileSystemOpen = true;
+    setWatchdogPhase(phase);
   }
-  else
+}
+
+void Datalogger::openFileSystemForFlush(void * datalogger)
+{
+  ((Datalogger *) datalogger)->openFileSystem();
+}
+
+void Datalogger::closeFileSystem()
+{
+  if (fileSystemOpen)
   {
-    debug(F("extADC not installed"));
+    watchdog_phase_type phase = setWatchdogPhase(watchdog_sd);
+    trace(trace_filesystem_close);
+    fileSystem->closeFileSystem(); // close file, filesystem
+    releasePowerDomains(POWER_DOMAIN_SD);
+    fileSystemOpen = false;
+    setWatchdogPhase(phase);
   }
+}
+
+void Datalogger::powerUpSwitchableComponents()
+{
+  // the datalogger itself only needs the switched rail, for the EEPROM on I2C1
+  // sensors and the SD card acquire the rest of their power domains as they start
+  // the bus was scanned at boot, the switched rail's settle time covers the delay
+  acquirePowerDomains(POWER_DOMAIN_SWITCHED);
+  resumeI2C1();
 
-  debug(F("Switchable components powered up"));
+  LOG_DEBUG(F("Switchable components powered up"));
 };
 
 void Datalogger::powerDownSwitchableComponents() // called in stopAndAwaitTrigger
 {
-  //TODO: hook for sensors that need to be powered down? separate functions?
   //TODO: hook for actuators that need to be powered down?
-  gpioPinOff(GPIO_PIN_3); //turn off 5v booster
   gpioPinOff(GPIO_PIN_6); //not in use currently
-  i2c_disable(I2C2);
-  digitalWrite(EXADC_RESET,LOW);
-  debug(F("Switchable components powered down"));
+  releasePowerDomains(POWER_DOMAIN_SWITCHED);
+  LOG_DEBUG(F("Switchable components powered down"));
 }
 
 void Datalogger::prepareForUserInteraction()
@@ -1124,34 +1644,53 @@ void Datalogger::prepareForUserInteraction()
 
 void Datalogger::stopAndAwaitTrigger()
 {
-  debug(F("Await measurement trigger"));
+  LOG_DEBUG(F("Await measurement trigger"));
 
   // printInterruptStatus(Serial2);
-  debug(F("Going to sleep"));
+  LOG_DEBUG(F("Going to sleep"));
 
   // save enabled interrupts
   int iser1, iser2, iser3;
   storeAllInterrupts(iser1, iser2, iser3);
 
   clearManualWakeInterrupt();
-  setNextAlarmInternalRTC(settings.interval);
 
-  // power down sensors -> function?
+  writeWakeTiming(); // a wake that ended without sampling
+
+  updateBatteryPolicy(); // once per wake, may stretch the schedule before the next deadline is taken
+
+  time_t wakeTime = scheduler.nextDeadline();
+  scheduledWakeTime = wakeTime;
+  if (wakeTime == SCHEDULER_NO_DEADLINE)
+  {
+    // no sensors scheduled, keep logging status fields on the datalogger interval
+    // as an epoch deadline, a stretched interval overflows the minute arithmetic in setNextAlarmInternalRTC()
+    unsigned long intervalSeconds = (unsigned long) settings.interval * battery.intervalMultiplier() * 60;
+    time_t now = timestamp();
+    setNextAlarmInternalRTCEpoch(now - now % intervalSeconds + intervalSeconds);
+  }
+  else
+  {
+    setNextAlarmInternalRTCEpoch(wakeTime);
+  }
+
+  commitDataloggerConfiguration(); // EEPROM is unpowered while asleep
+
+  // power down sensors, the due ones are set up again in initializeMeasurementCycle
   for (unsigned int i = 0; i < sensorCount; i++)
   {
-    drivers[i]->stop();
+    stopSensor(drivers[i]);
   }
 
-  powerDownSwitchableComponents();
-  fileSystem->closeFileSystem(); // close file, filesystem
-  disableSwitchedPower();
+  closeFileSystem();
+  powerDownSwitchableComponents(); // every domain is released by now, so the switched rail goes off
 
   awakenedByUser = false; // Don't go into sleep mode with any interrupt state
 
   componentsStopMode();
 
-  disableCustomWatchDog();
-  debug(F("disabled watchdog"));
+  setWatchdogPhase(watchdog_sleep); // keeps running in stop mode
+  SerialOutput.drain();   // the USART and DMA stop with the clocks
   disableSerialLog();     // TODO
   hardwarePinsStopMode(); // switch to input mode
 
@@ -1161,27 +1700,43 @@ void Datalogger::stopAndAwaitTrigger()
   enableManualWakeInterrupt();    // The button, which is not powered during stop mode on v0.2 hardware
   nvic_irq_enable(NVIC_RTCALARM); // enable our RTC alarm interrupt
 
-  enterStopMode();
+  trace(trace_sleep, sensorCount);
+  uint32 sleepStartTicks = internalRTCTicks();
+  uint32 wakeAlarmTicks = internalRTCAlarmTicks();
+  while (true)
+  {
+    // wake early to feed the watchdog while the alarm is further off than it can wait
+    feedWatchdog();
+    uint32 feedTicks = internalRTCTicks() + watchdogFeedIntervalMilliseconds() * 128 / 125;
+    bool feeding = (long) (wakeAlarmTicks - feedTicks) > 0;
+    setInternalRTCAlarm(feeding ? feedTicks : wakeAlarmTicks);
+    enterStopMode();
+    if (awakenedByUser || !feeding)
+    {
+      break;
+    }
+  }
+  feedWatchdog();
 
+  addSleepToMillis(sleepStartTicks);
+  trace(trace_wake, awakenedByUser);
+  if (!awakenedByUser)
+  {
+    wakeTiming.begin(internalRTCAlarmTicks());
+    wakeTiming.mark(wake_phase_resumed);
+  }
   reenableAllInterrupts(iser1, iser2, iser3);
   disableManualWakeInterrupt();
   nvic_irq_disable(NVIC_RTCALARM);
 
   enableSerialLog();
-  enableSwitchedPower();
-
-  // power up sensors -> function?
-  for (unsigned int i = 0; i < sensorCount; i++)
-  {
-    drivers[i]->setup();
-  }
 
   setupHardwarePins(); // used from setup steps in datalogger
 
-  debug(F("Awoke"));
+  LOG_DEBUG(F("Awoke"));
 
-  startCustomWatchDog(); // could go earlier once working reliably
-  // delay( (DEFAULT_WATCHDOG_TIMEOUT_SECONDS + 5) * 1000); // to test the watchdog
+  setWatchdogPhase(watchdog_measurement);
+  wakeTiming.mark(wake_phase_restored);
 
   if (awakenedByUser == true)
   {
@@ -1191,10 +1746,32 @@ void Datalogger::stopAndAwaitTrigger()
   // We have woken from the interrupt
   // printInterruptStatus(Serial2);
 
-  powerUpSwitchableComponents();
-  // turn components back on
+  // turn components back on, only the power domains of the due sensors are switched on
+  // and they are switched on together so their settle times overlap, rather than
+  // settling one sensor at a time as each is set up
   componentsBurstMode();
-  fileSystem->reopenFileSystem();
+  bool openingFileSystem = !battery.batchWrites() || fileSystemWriteCache->available() < BATTERY_BATCH_RESERVE_BYTES;
+  unsigned short wakePowerDomains = POWER_DOMAIN_SWITCHED | powerDomainsForScheduledSensors(scheduledWakeTime);
+  if (openingFileSystem)
+  {
+    wakePowerDomains |= POWER_DOMAIN_SD;
+  }
+  acquirePowerDomains(wakePowerDomains);
+  powerUpSwitchableComponents();
+  wakeTiming.mark(wake_phase_powered);
+
+  checkClock(); // the one DS3231 read per wake
+  wakeTiming.mark(wake_phase_clock_checked);
+
+  startScheduledSensors(scheduledWakeTime); // warm up while the SD card mounts
+  wakeTiming.mark(wake_phase_sensors_started);
+
+  if (openingFileSystem)
+  {
+    openFileSystem();
+    wakeTiming.mark(wake_phase_filesystem_opened);
+  }
+  releasePowerDomains(wakePowerDomains); // held by the sensors and the filesystem from here
 
   if (awakenedByUser == true)
   {
@@ -1210,13 +1787,43 @@ void Datalogger::stopAndAwaitTrigger()
 
 void Datalogger::storeDataloggerConfiguration()
 {
-  writeDataloggerSettingsToEEPROM(&this->settings);
+  // only updates the RAM mirror, see commitDataloggerConfiguration()
+  dataloggerConfigurationStore.write(&this->settings, sizeof(datalogger_settings_type));
+}
+
+void Datalogger::commitDataloggerConfiguration()
+{
+  if (dataloggerConfigurationStore.isDirty())
+  {
+    configurationCached = false; // flash configuration cache no longer matches EEPROM
+  }
+  dataloggerConfigurationStore.commit();
 }
 
 void Datalogger::storeSensorConfiguration(SensorDriver * driver)
 {
   const configuration_bytes configurationBytes = driver->getConfigurationBytes();
   writeSensorConfigurationToEEPROM(driver->getSlot(), &configurationBytes);
+  sensorConfigurationChanged();
+}
+
+void Datalogger::sensorConfigurationChanged()
+{
+  // slot blocks have no crc of their own, bumping the generation changes the settings crc
+  // which marks the flash configuration cache as stale
+  settings.sensorConfigurationGeneration++;
+  storeDataloggerConfiguration();
+}
+
+void Datalogger::refreshConfigurationCache()
+{
+  commitDataloggerConfiguration(); // the cache is copied from EEPROM
+  if (configurationCached)
+  {
+    return;
+  }
+  rebuildConfigurationCache();
+  configurationCached = true;
 }
 
 void Datalogger::setSiteName(char *siteName)
@@ -1250,16 +1857,23 @@ const char *Datalogger::getUUIDString()
 
 int Datalogger::minMillisecondsUntilNextReading()
 {
+  // only sensors still bursting pace the burst, finished or unscheduled ones would hold it back
   unsigned int minimumNextRequestedReading = MAX_REQUESTED_READING_DELAY; 
   for(int i=0; i<sensorCount; i++)
   {
-    minimumNextRequestedReading = min(minimumNextRequestedReading, drivers[i]->millisecondsUntilNextRequestedReading());
+    if (inCurrentBurst(drivers[i]) && !drivers[i]->burstCompleted())
+    {
+      minimumNextRequestedReading = min(minimumNextRequestedReading, drivers[i]->millisecondsUntilNextRequestedReading());
+    }
   }
 
   unsigned int maxDelayUntilNextAvailableReading = 0; 
   for(int i=0; i<sensorCount; i++)
   {
-    maxDelayUntilNextAvailableReading = max(maxDelayUntilNextAvailableReading, drivers[i]->millisecondsUntilNextReadingAvailable());
+    if (inCurrentBurst(drivers[i]) && !drivers[i]->burstCompleted())
+    {
+      maxDelayUntilNextAvailableReading = max(maxDelayUntilNextAvailableReading, drivers[i]->millisecondsUntilNextReadingAvailable());
+    }
   }
   
   // we want to read as fast the speed requested by the fastest sensor
@@ -1286,16 +1900,35 @@ void Datalogger::setSensorDebugModes(bool debug)
 
 void Datalogger::outputLastMeasurement()
 {
-  Serial2.print("\n");
+  // a full queue loses the line rather than holding up the next measurement
+  serial_tx_policy_type previousPolicy = SerialOutput.setPolicy(serial_tx_drop);
+  SerialOutput.print("\n");
+  printLastMeasurement(SerialOutput);
+  SerialOutput.setPolicy(previousPolicy);
+}
+
+void Datalogger::printLastMeasurement(Print &output)
+{
   for (unsigned short i = 0; i < sensorCount; i++)
   {
-    Serial2.print(drivers[i]->getCSVColumnHeaders());
-    Serial2.print(i < sensorCount - 1 ? "," : "\n");
+    output.print(drivers[i]->getCSVColumnHeaders());
+    output.print(i < sensorCount - 1 ? "," : "\n");
   }
 
   for (unsigned short i = 0; i < sensorCount; i++)
   {
-    Serial2.print(drivers[i]->getRawDataString());
-    Serial2.print(i < sensorCount - 1 ? "," : "\n");
+    output.print(drivers[i]->getRawDataString());
+    output.print(i < sensorCount - 1 ? "," : "\n");
+  }
+}
+
+void Datalogger::printLiveValues(Print &output)
+{
+  // while logging, or with interactive logging on, the last row is current
+  // otherwise measure now, the idle depth limit keeps the serial port listening
+  if (!interactiveModeLogging && !inMode(logging))
+  {
+    measureSensorValues(false);
   }
+  printLastMeasurement(output);
 }
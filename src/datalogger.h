@@ -29,22 +29,30 @@
 // #include "system/ble.h"
 #include "system/clock.h"
 #include "system/command.h"
+#include "system/configuration_cache.h"
+#include "system/configuration_store.h"
 #include "system/eeprom.h"
 #include "system/filesystem.h"
 #include "system/hardware.h"
 #include "system/interrupts.h"
 #include "system/low_power.h"
 #include "system/monitor.h"
+#include "system/power_domains.h"
+#include "system/scheduler.h"
 #include "system/switched_power.h"
+#include "system/wake_timing.h"
 #include "system/adc.h"
+#include "system/battery.h"
 #include "system/write_cache.h"
+#include "system/sample_stream.h"
 
 #include "sensors/sensor.h"
 
 #define DEPLOYMENT_IDENTIFIER_LENGTH 16
+#define WARM_UP_POLL_MILLISECONDS 100 // for drivers that only report isWarmedUp()
 
-// 64 bytes max, one configuration_partition_bytes
-// Currently there are 14 bytes unused
+// 60 bytes max, one configuration_partition_bytes less the configuration store trailer
+// Currently there are 2 bytes unused
 typedef struct datalogger_settings { 
     char deploymentIdentifier[16]; // 16 bytes
     char siteName[8]; // 8 bytes
@@ -60,7 +68,11 @@ typedef struct datalogger_settings {
     byte withold_incomplete_readings : 1; // only publish complete readings, default to withold.
     byte log_raw_data : 1;
     byte reserved2 : 4;
+    unsigned short sensorConfigurationGeneration; // 2 bytes, changes with every slot write so the settings crc does too
+    unsigned short batteryFullScaleMillivolts; // 2 bytes, calibrated battery divider, see BatteryPolicy
+    byte batteryTierDecivolts[BATTERY_TIER_COUNT]; // 4 bytes, 0 disables the tier
 } datalogger_settings_type;
+static_assert(sizeof(datalogger_settings_type) <= CONFIGURATION_STORE_PAYLOAD_SIZE, "datalogger settings overlap the configuration store trailer");
  
 typedef enum mode { interactive, debugging, logging, deploy_on_trigger } mode_type;
 
@@ -77,7 +89,7 @@ public:
     bool * dirtyConfigurations = NULL;      // configuration change tracking
     short * sensorTypes = NULL;
     void ** sensorConfigurations = NULL;
-    SensorDriver ** drivers = NULL;
+    SensorDriver * drivers[EEPROM_TOTAL_SENSOR_SLOTS]; // configured drivers in slot order, sensorCount entries
     datalogger_settings_type settings;
 
     static void readConfiguration(datalogger_settings_type * settings);
@@ -106,16 +118,19 @@ public:
     void setStartUpDelay(int delay);
     void setIntraBurstDelay(int delay);
 
-    void setConfiguration(cJSON * config);
+    bool setConfiguration(JSONReader & config); // false if any member was rejected
     void getConfiguration(datalogger_settings_type * dataloggerSettings);
-    cJSON * getSensorConfiguration(short index);
+    void getConfigurationJSON(JSONWriter & json);
+    void getSensorConfiguration(short index, JSONWriter & json);
 
-    void setSensorConfiguration(char * type, cJSON * json);
-    void clearSlot(unsigned short slot);
+    bool setSensorConfiguration(JSONReader & json);
+    bool clearSlot(unsigned short slot);
     void storeSensorConfigurationIfNeedsSave();
 
     void calibrate(unsigned short slot, char * subcommand, int arg_cnt, char ** args);
     void setExternalADCEnabled(bool enabled);
+    void calibrateBattery(unsigned short measuredMillivolts);
+    void setBatteryTiers(unsigned short * tierMillivolts);
 
     void setUserNote(char * note);
     void setUserValue(int value);
@@ -127,6 +142,19 @@ public:
 
     const char * getUUIDString();
 
+    // the CSV header and values lines outputLastMeasurement() prints, measured now unless logging or interactive logging is on
+    void printLiveValues(Print & output);
+
+    // binary sample streaming in interactive mode, slots selected by bit, 0 for every configured slot
+    bool startStreaming(unsigned short slotMask); // false if a selected slot has no sensor
+    void stopStreaming();
+    unsigned short describeStream(byte * body, unsigned short capacity);
+    void getStreamCounts(uint32 * sent, uint32 * dropped);
+
+    // data files for the binary protocol, opens the filesystem if it is closed
+    bool listFiles(const char * path, directory_visitor visitor, void * context);
+    int readFile(const char * path, uint32 offset, void * buffer, unsigned short length);
+
     void reloadSensorConfigurations(); // for dev & debug
     void stopAndAwaitTrigger(); // public for dev & debug
 
@@ -140,28 +168,49 @@ private:
     mode_type mode = interactive;
     bool powerCycle = true;
     bool interactiveModeLogging = false;
-    time_t currentEpoch;
-    uint32 offsetMillis;
     char loggingFolder[26];
-    int completedBursts;
     int awakeTime;
 
+    // scheduling, indexed by slot
+    Scheduler scheduler;
+    bool sensorDue[EEPROM_TOTAL_SENSOR_SLOTS];              // selected for the current measurement cycle
+    unsigned short burstsRemaining[EEPROM_TOTAL_SENSOR_SLOTS];
+    bool sensorRunning[EEPROM_TOTAL_SENSOR_SLOTS];          // setup() called without a matching stop()
+    bool sensorHibernating[EEPROM_TOTAL_SENSOR_SLOTS];      // in standby between bursts
+    uint32 sensorStartedAt[EEPROM_TOTAL_SENSOR_SLOTS];      // millis() when setup() was called
+    unsigned short sensorPowerDomains[EEPROM_TOTAL_SENSOR_SLOTS]; // acquired by startSensor(), released by stopSensor()
+    uint32 sampleCapturedAt[EEPROM_TOTAL_SENSOR_SLOTS];     // internal RTC ticks when the last sample was collected
+    uint32 rowSampleTicks = 0;                              // first sample collected by the last measureSensorValues()
+    time_t scheduledWakeTime = 0;
+    time_t nextMemoryStatusTime = 0;                        // memory row due in the data file
+
+    // power
+    BatteryPolicy battery;
+    bool fileSystemOpen = false;                            // SD powered and the log file open
+    WakeTiming wakeTiming;                                  // alarm to first sample, per wake
+
     // user
     char userNote[100] = "\0";
     int userValue = INT_MIN;
     int lastInteractiveLogTime = 0;
 
+    // streaming
+    SampleStream sampleStream;
+    bool streamMeasuring[EEPROM_TOTAL_SENSOR_SLOTS];         // started, waiting to be collected
+
     void loadSensorConfigurations();
     bool shouldExitLoggingMode();
     void measureSensorValues(bool performingBurst = true);
     bool writeRawMeasurementToLogFile();
     bool writeSummaryMeasurementToLogFile();
     void writeDebugFieldsToLogFile();
+    void writeWakeTiming();
+    void writeMemoryStatusIfDue();
     bool configurationIsDirty();
-    void storeConfiguration();
     void initializeBurst();
     bool shouldContinueBursting();
     bool processReadingsCycle();
+    void streamSamples();
 
     // CLI
     CommandInterface * cli;
@@ -169,19 +218,47 @@ private:
     void setUpCLI();
 
     // utility
-    void writeStatusFieldsToLogFile(const char * type);
+    void writeStatusFieldsToLogFile(const char * type, uint32 sampleTicks);
     void writeUserFieldsToLogFile();
-    void initializeMeasurementCycle();
+    void initializeMeasurementCycle(bool scheduled = false);
     void outputLastMeasurement();
+    void printLastMeasurement(Print & output);
+
+    // scheduling
+    void scheduleSensors();
+    void selectAllSensors();
+    bool sensorsDue();
+    bool inCurrentBurst(SensorDriver * driver);
+    unsigned short burstNumberForSensor(SensorDriver * driver);
+    void startSensor(SensorDriver * driver);
+    void stopSensor(SensorDriver * driver);
+    void startScheduledSensors(time_t wakeTime);
+    unsigned short powerDomainsForScheduledSensors(time_t wakeTime);
+    unsigned int millisecondsUntilSensorsWarmedUp();
+    void writeEmptyColumns(SensorDriver * driver);
+
+    // battery
+    void configureBatteryPolicy();
+    void updateBatteryPolicy();
+
+    // standby
+    void sleepWithSensorsInStandby(uint32 milliseconds);
+    void placeSensorsInStandbyMode(uint32 milliseconds);
+    void wakeSensorsFromStandbyMode();
 
     void storeDataloggerConfiguration();
+    void commitDataloggerConfiguration();
     void storeSensorConfiguration(SensorDriver * driver);
+    void sensorConfigurationChanged();
+    void refreshConfigurationCache();
 
-    void sleepMCU(uint32 milliseconds);
     int minMillisecondsUntilNextReading();
  
     // run loop
     void initializeFilesystem();
+    void openFileSystem();
+    void closeFileSystem();
+    static void openFileSystemForFlush(void * datalogger); // rows overflowing the write cache while SD writes are batched
     // void stopAndAwaitTrigger();
     void writeStatusFields(const char * type);
     void prepareForUserInteraction();
@@ -189,7 +266,9 @@ private:
     void powerDownSwitchableComponents();
 
     // utility
+    SensorDriver * slotDrivers[EEPROM_TOTAL_SENSOR_SLOTS]; // indexed by slot, NULL when empty
     SensorDriver * getDriver(unsigned short slot);
+    void rebuildDriverList();
 
     // debugging
     void debugValues(char * buffer);
@@ -21,6 +21,8 @@
 
 #include "datalogger.h"
 #include "system/watchdog.h"
+#include "system/trace.h"
+#include "system/memory.h"
 #include "system/hardware.h"
 #include "utilities/i2c.h"
 #include "utilities/qos.h"
@@ -36,13 +38,14 @@ void workspace();
 
 void setup(void)
 {
+  startMemoryAccounting(); // before anything allocates
   startSerial2();
   Monitor::instance()->debugToSerial = true;
 
   workspace();
 
-  startCustomWatchDog();
-  printWatchDogStatus();
+  startTrace(); // before startWatchdog() clears the reset flags
+  startWatchdog();
 
   // disable unused components and hardware pins
   componentsAlwaysOff();
@@ -67,7 +70,7 @@ void setup(void)
   debug(F("done with setup"));
   notifyDebugStatus();
 
-  startCustomWatchDog(); // printMCUDebugStatus delays with user message, don't want watchdog to trigger
+  feedWatchdog(); // printMCUDebugStatus delays with user message, don't want watchdog to trigger
 
   Monitor::instance()->debugToSerial = false;
 
@@ -77,28 +80,26 @@ void setup(void)
   {
     notify("Device will enter logging mode in 5 seconds");
     notify("Type 'i' to exit to interactive mode");
-    Serial2.print("CMD >> ");
+    SerialOutput.print("CMD >> ");
     int start = timestamp();
     int now = start;
     while (now < start + 5)
     {
-      startCustomWatchDog();
+      feedWatchdog();
       datalogger->processCLI();
       now = timestamp();
     }
   }
   else
   {
-    Serial2.print("CMD >> ");
-    Serial2.flush();
+    SerialOutput.print("CMD >> ");
   }
 
 }
 
 void loop(void)
 {
-  startCustomWatchDog();
-  printWatchDogStatus();
+  feedWatchdog();
   checkMemory();
 
   datalogger->loop();
@@ -0,0 +1,70 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "driver_pool.h"
+#include "sensor.h"
+
+typedef union driver_cell
+{
+  byte storage[DRIVER_POOL_CELL_SIZE];
+  unsigned long long align; // drivers hold 8 byte timestamps
+} driver_cell_type;
+
+static driver_cell_type cells[DRIVER_POOL_CELL_COUNT];
+static bool cellInUse[DRIVER_POOL_CELL_COUNT];
+
+void * allocateDriverCell()
+{
+  for (unsigned short i = 0; i < DRIVER_POOL_CELL_COUNT; i++)
+  {
+    if (!cellInUse[i])
+    {
+      cellInUse[i] = true;
+      return cells[i].storage;
+    }
+  }
+  return NULL;
+}
+
+void releaseDriver(SensorDriver * driver)
+{
+  if (driver == NULL)
+  {
+    return;
+  }
+  driver->~SensorDriver();
+  for (unsigned short i = 0; i < DRIVER_POOL_CELL_COUNT; i++)
+  {
+    if ((void *) driver == (void *) cells[i].storage)
+    {
+      cellInUse[i] = false;
+    }
+  }
+}
+
+unsigned short driverCellsInUse()
+{
+  unsigned short count = 0;
+  for (unsigned short i = 0; i < DRIVER_POOL_CELL_COUNT; i++)
+  {
+    if (cellInUse[i])
+    {
+      count++;
+    }
+  }
+  return count;
+}
@@ -0,0 +1,40 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_DRIVER_POOL
+#define WATERBEAR_DRIVER_POOL
+
+#include <Arduino.h>
+#include "system/eeprom.h"
+
+// Drivers are constructed in place in fixed cells instead of on the heap, so
+// configuring and reconfiguring sensors can't fragment the 20 KB of RAM.
+// Drivers keep their library objects inside themselves, see AdaDHT22.
+#define DRIVER_POOL_CELL_SIZE 384 // the largest registered driver, AdaDHT22, checked at compile time in createInstance()
+#define DRIVER_POOL_CELL_COUNT (EEPROM_TOTAL_SENSOR_SLOTS + 1) // every slot, plus one built before the driver it replaces is released
+
+class SensorDriver;
+
+// NULL when every cell is in use
+void * allocateDriverCell();
+
+// Runs the driver's destructor and returns its cell to the pool
+void releaseDriver(SensorDriver * driver);
+
+unsigned short driverCellsInUse();
+
+#endif
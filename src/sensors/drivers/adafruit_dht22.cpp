@@ -1,6 +1,7 @@
 #include "sensors/drivers/adafruit_dht22.h"
 #include "system/logs.h" // for debug() and notify()
 #include "system/hardware.h" // for pin names
+#include <new>
 
 short GPIO_PINS[7] = {
     GPIO_PIN_1,
@@ -20,7 +21,13 @@ AdaDHT22::AdaDHT22()
   //debug("allocating AdaDHT22")
 }
 
-AdaDHT22::~AdaDHT22(){}
+AdaDHT22::~AdaDHT22()
+{
+  if (dht != NULL)
+  {
+    dht->~DHT_Unified();
+  }
+}
 
 const char * AdaDHT22::getSensorTypeString()
 {
@@ -41,10 +48,10 @@ void AdaDHT22::configureSpecificConfigurationsFromBytes(configuration_bytes_part
 }
 
 
-void AdaDHT22::appendDriverSpecificConfigurationJSON(cJSON * json)
+void AdaDHT22::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
   // debug("getting AdaDHT22 json");
-  cJSON_AddNumberToObject(json, "sensor_pin", configuration.sensor_pin + 1);
+  json.addInteger("sensor_pin", configuration.sensor_pin + 1);
 
   //driver specific config, customize
   addCalibrationParametersToJSON(json);
@@ -54,14 +61,17 @@ void AdaDHT22::setup()
 {
   // debug("setup AdaDHT22");
   short gpioPin = GPIO_PINS[configuration.sensor_pin];
-  dht = new DHT_Unified(gpioPin, DHTTYPE);
+  if (dht == NULL)
+  {
+    dht = new (dhtStorage) DHT_Unified(gpioPin, DHTTYPE);
+  }
   dht->begin();
+  readBefore = false;
   // notify("AdaDHT22 Initialized");
 }
 
 void AdaDHT22::stop()
 {
-  free(dht);
   pinMode(GPIO_PINS[configuration.sensor_pin], INPUT);
   digitalWrite(GPIO_PINS[configuration.sensor_pin], LOW);
   // notify("AdaDHT22 stopped");
@@ -72,6 +82,8 @@ bool AdaDHT22::takeMeasurement()
   // debug("taking measurement from AdaDHT22");
   sensors_event_t event;
   bool measurementTaken = false;
+  readBefore = true;
+  lastReadAt = millis();
 
   dht->temperature().getEvent(&event);
   temperature = event.temperature;
@@ -104,6 +116,20 @@ bool AdaDHT22::takeMeasurement()
   return measurementTaken;
 }
 
+uint32 AdaDHT22::measurementReadyAt()
+{
+  if (!readBefore)
+  {
+    return measurementStartedAt;
+  }
+  uint32 nextReadAt = lastReadAt + ADAFRUIT_DHT22_READ_INTERVAL_MS;
+  if ((long) (nextReadAt - measurementStartedAt) > 0)
+  {
+    return nextReadAt;
+  }
+  return measurementStartedAt;
+}
+
 const char *AdaDHT22::getRawDataString()
 {
   // debug("configuring AdaDHT22 dataString");
@@ -112,6 +138,13 @@ const char *AdaDHT22::getRawDataString()
   return dataString;
 }
 
+unsigned short AdaDHT22::getRawValues(float * values)
+{
+  values[0] = temperature;
+  values[1] = humidity;
+  return 2;
+}
+
 const char *AdaDHT22::getSummaryDataString()
 {
   double temperatureBurstSummaryMean = getBurstSummaryMean(TEMPERATURE_VALUE_TAG);
@@ -138,20 +171,20 @@ void AdaDHT22::calibrationStep(char *step, int arg_cnt, char ** args)
   // debug("AdaDHT22 calibration steps");
 }
 
-void AdaDHT22::addCalibrationParametersToJSON(cJSON *json)
+void AdaDHT22::addCalibrationParametersToJSON(JSONWriter &json)
 {
   // follows structure of calibration parameters in .h
   // debug("add AdaDHT22 calibration parameters to json");
-  cJSON_AddNumberToObject(json, CALIBRATION_TIME_STRING, configuration.cal_timestamp);
+  json.addInteger(CALIBRATION_TIME_STRING, configuration.cal_timestamp);
 }
 
-bool AdaDHT22::configureDriverFromJSON(cJSON *json)
+bool AdaDHT22::configureDriverFromJSON(JSONReader &json)
 {
-  const cJSON *sensorPinJSON = cJSON_GetObjectItemCaseSensitive(json, "sensor_pin");
+  long sensorPin;
   int gpioPinCount = 7;  
-  if (sensorPinJSON->valueint > 0 && sensorPinJSON->valueint <= gpioPinCount)
+  if (json.getInteger("sensor_pin", &sensorPin) && sensorPin > 0 && sensorPin <= gpioPinCount)
   {
-    configuration.sensor_pin = (byte)sensorPinJSON->valueint - 1;
+    configuration.sensor_pin = (byte)sensorPin - 1;
   }
   else
   {
@@ -26,6 +26,7 @@
 #define DHTTYPE DHT22   // DHT 22 (AM2302)
 
 #define ADAFRUIT_DHT22_TYPE_STRING "adafruit_dht22"
+#define ADAFRUIT_DHT22_READ_INTERVAL_MS 2000 // the DHT22 converts at most every 2 s, sooner the library repeats the last reading
 
 class AdaDHT22 : public GPIOProtocolSensorDriver
 {
@@ -48,7 +49,9 @@ class AdaDHT22 : public GPIOProtocolSensorDriver
     void setup();
     void stop();
     bool takeMeasurement();
+    uint32 measurementReadyAt();
     const char * getRawDataString();
+    unsigned short getRawValues(float * values);
     const char * getSummaryDataString();
     const char * getBaseColumnHeaders();
     void initCalibration();
@@ -57,21 +60,25 @@ class AdaDHT22 : public GPIOProtocolSensorDriver
   protected:
     void configureSpecificConfigurationsFromBytes(configuration_bytes_partition configurations);
     configuration_bytes_partition getDriverSpecificConfigurationBytes();
-    bool configureDriverFromJSON(cJSON *json);
-    void appendDriverSpecificConfigurationJSON(cJSON *json);
+    bool configureDriverFromJSON(JSONReader &json);
+    void appendDriverSpecificConfigurationJSON(JSONWriter &json);
     void setDriverDefaults();
 
   private:
     const char *sensorTypeString = "adafruit_dht22";
     driver_configuration configuration;
-    DHT_Unified *dht;
+    DHT_Unified *dht = NULL; // constructed in dhtStorage on the first setup(), kept until the driver is released
+    alignas(DHT_Unified) byte dhtStorage[sizeof(DHT_Unified)];
+
+    bool readBefore = false; // since setup()
+    uint32 lastReadAt = 0;   // millis() of the last takeMeasurement()
 
     float temperature;
     float humidity;
     const char *baseColumnHeaders = "C,RH"; // will be written to .csv
     char dataString[16]; // will be written to .csv
 
-    void addCalibrationParametersToJSON(cJSON *json);
+    void addCalibrationParametersToJSON(JSONWriter &json);
 };
 
 #endif
\ No newline at end of file
@@ -1,5 +1,6 @@
 #include "sensors/drivers/atlas_co2_driver.h"
 #include "system/logs.h" // for debug() and notify()
+#include <new>
 
 #define CO2_TAG "co2"
 
@@ -8,7 +9,13 @@ AtlasCO2Driver::AtlasCO2Driver()
   // debug("allocating driver template");
 }
 
-AtlasCO2Driver::~AtlasCO2Driver(){}
+AtlasCO2Driver::~AtlasCO2Driver()
+{
+  if (modularSensorDriver != NULL)
+  {
+    modularSensorDriver->~AtlasScientificCO2();
+  }
+}
 
 const char * AtlasCO2Driver::getSensorTypeString()
 {
@@ -27,7 +34,7 @@ void AtlasCO2Driver::configureSpecificConfigurationsFromBytes(configuration_byte
   memcpy(&configuration, &configurationPartition, sizeof(driver_config));
 }
 
-void AtlasCO2Driver::appendDriverSpecificConfigurationJSON(cJSON * json)
+void AtlasCO2Driver::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
   // debug("appeding driver specific driver template json");
   
@@ -38,7 +45,10 @@ void AtlasCO2Driver::appendDriverSpecificConfigurationJSON(cJSON * json)
 void AtlasCO2Driver::setup()
 {
   // debug("setup AtlasCO2Driver");
-  modularSensorDriver = new AtlasScientificCO2(wire,-1);
+  if (modularSensorDriver == NULL)
+  {
+    modularSensorDriver = new (modularSensorStorage) AtlasScientificCO2(wire,-1);
+  }
   if(!modularSensorDriver->setup()){
     notify("CO2 setup failed");
   }
@@ -51,12 +61,50 @@ void AtlasCO2Driver::stop()
   // debug("stop/delete AtlasCO2Driver");
 }
 
+void AtlasCO2Driver::hibernate()
+{
+  modularSensorDriver->sleep();
+}
+
+void AtlasCO2Driver::wake()
+{
+  modularSensorDriver->wake();
+}
+
+unsigned int AtlasCO2Driver::hibernateBreakEvenMilliseconds()
+{
+  return CO2_HIBERNATE_BREAK_EVEN_MILLIS;
+}
+
+unsigned int AtlasCO2Driver::wakeLatencyMilliseconds()
+{
+  return CO2_WAKE_LATENCY_MILLIS;
+}
+
 bool AtlasCO2Driver::takeMeasurement()
 {
-  // debug("taking measurement from driver template");
-  //return true if measurement taken store in class value(s), false if not
+  startMeasurement();
+  return collectMeasurement();
+}
+
+void AtlasCO2Driver::startMeasurement()
+{
+  measurementStartedAt = millis();
   modularSensorDriver->startSingleMeasurement();
-  modularSensorDriver->waitForMeasurementCompletion();
+}
+
+uint32 AtlasCO2Driver::measurementReadyAt()
+{
+  return measurementStartedAt + modularSensorDriver->getMeasurementTime();
+}
+
+bool AtlasCO2Driver::collectMeasurement()
+{
+  //return true if measurement taken store in class value(s), false if not
+  if (!modularSensorDriver->isMeasurementComplete())
+  {
+    modularSensorDriver->waitForMeasurementCompletion();
+  }
   bool measurementTaken = modularSensorDriver->addSingleMeasurementResult();
   if(measurementTaken)
   {
@@ -80,6 +128,12 @@ const char * AtlasCO2Driver::getRawDataString()
   return dataString;
 }
 
+unsigned short AtlasCO2Driver::getRawValues(float * values)
+{
+  values[0] = value;
+  return 1;
+}
+
 const char * AtlasCO2Driver::getSummaryDataString()
 {
   sprintf(dataString, "%0.2f", getBurstSummaryMean(CO2_TAG));
@@ -104,14 +158,14 @@ void AtlasCO2Driver::calibrationStep(char *step, int arg_cnt, char ** args)
   // debug("driver template calibration steps");
 }
 
-void AtlasCO2Driver::addCalibrationParametersToJSON(cJSON *json)
+void AtlasCO2Driver::addCalibrationParametersToJSON(JSONWriter &json)
 {
   // follows structure of calibration parameters in .h
   // debug("add driver template calibration parameters to json");
-  cJSON_AddNumberToObject(json, CALIBRATION_TIME_STRING, configuration.cal_timestamp);
+  json.addInteger(CALIBRATION_TIME_STRING, configuration.cal_timestamp);
 }
 
-bool AtlasCO2Driver::configureDriverFromJSON(cJSON *json)
+bool AtlasCO2Driver::configureDriverFromJSON(JSONReader &json)
 {
   // debug("configuring driver template driver from json");
   return true;
@@ -26,6 +26,8 @@
 //#define any pins/static options used
 
 #define ATLAS_CO2_DRIVER_TYPE_STRING "atlas_co2"
+#define CO2_HIBERNATE_BREAK_EVEN_MILLIS 60000
+#define CO2_WAKE_LATENCY_MILLIS 10000 // readings settle about 10 s after waking
 
 
 class AtlasCO2Driver : public I2CProtocolSensorDriver
@@ -45,23 +47,32 @@ class AtlasCO2Driver : public I2CProtocolSensorDriver
     // Interface
     void configureSpecificConfigurationsFromBytes(configuration_bytes_partition configurations);
     configuration_bytes_partition getDriverSpecificConfigurationBytes();
-    void appendDriverSpecificConfigurationJSON(cJSON * json);
+    void appendDriverSpecificConfigurationJSON(JSONWriter &json);
     void setup();
     void stop();
+    void hibernate();
+    void wake();
+    unsigned int hibernateBreakEvenMilliseconds();
+    unsigned int wakeLatencyMilliseconds();
     bool takeMeasurement();
+    void startMeasurement();
+    uint32 measurementReadyAt();
+    bool collectMeasurement();
     const char * getRawDataString();
+    unsigned short getRawValues(float * values);
     const char * getSummaryDataString();
     const char * getBaseColumnHeaders();
     void initCalibration();
     void calibrationStep(char *step, int arg_cnt, char ** args);
 
   protected:
-    bool configureDriverFromJSON(cJSON *json);
+    bool configureDriverFromJSON(JSONReader &json);
     void setDriverDefaults();
 
   private:
     //sensor specific variables, functions, etc.
-    AtlasScientificCO2 *modularSensorDriver;
+    AtlasScientificCO2 *modularSensorDriver = NULL; // constructed in modularSensorStorage on the first setup()
+    alignas(AtlasScientificCO2) byte modularSensorStorage[sizeof(AtlasScientificCO2)];
     CampbellOBS3 * campbell;
     driver_config configuration;
 
@@ -73,7 +84,7 @@ class AtlasCO2Driver : public I2CProtocolSensorDriver
     const char *baseColumnHeaders = "CO2_ppm,temperature_C"; // will be written to .csv
     char dataString[30]; // will be written to .csv
 
-    void addCalibrationParametersToJSON(cJSON *json);
+    void addCalibrationParametersToJSON(JSONWriter &json);
 };
 
 #endif
\ No newline at end of file
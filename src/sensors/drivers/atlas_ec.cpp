@@ -21,6 +21,7 @@
 #include "system/measurement_components.h"
 #include "system/eeprom.h" // TODO: ideally not included in this scope
 #include "system/clock.h"  // TODO: ideally not included in this scope
+#include <new>
 
 #define EC_TAG "ec"
 
@@ -29,7 +30,13 @@ AtlasECDriver::AtlasECDriver()
   // debug("allocation AtlasECDriver");
 }
 
-AtlasECDriver::~AtlasECDriver(){}
+AtlasECDriver::~AtlasECDriver()
+{
+  if (oem_ec != NULL)
+  {
+    oem_ec->~EC_OEM();
+  }
+}
 
 const char * AtlasECDriver::getSensorTypeString()
 {
@@ -51,7 +58,10 @@ void AtlasECDriver::configureSpecificConfigurationsFromBytes(configuration_bytes
 void AtlasECDriver::setup()
 {
   // notify("setup AtlasECDriver");
-  oem_ec = new EC_OEM(wire, NONE_INT, ec_i2c_id);
+  if (oem_ec == NULL)
+  {
+    oem_ec = new (oemStorage) EC_OEM(wire, NONE_INT, ec_i2c_id);
+  }
 
   if (true)
   {
@@ -86,6 +96,16 @@ void AtlasECDriver::wake()
   oem_ec->wakeUp();
 }
 
+unsigned int AtlasECDriver::hibernateBreakEvenMilliseconds()
+{
+  return EC_HIBERNATE_BREAK_EVEN_MILLIS;
+}
+
+unsigned int AtlasECDriver::wakeLatencyMilliseconds()
+{
+  return EC_WAKE_LATENCY_MILLIS;
+}
+
 void AtlasECDriver::setDebugMode(bool debug) // for setting internal debug parameters, such as LED on
 {
   oem_ec->setLedOn(debug);
@@ -96,7 +116,7 @@ void AtlasECDriver::setDriverDefaults()
   configuration.cal_timestamp = 0;
 }
 
-void AtlasECDriver::appendDriverSpecificConfigurationJSON(cJSON * json)
+void AtlasECDriver::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
   addCalibrationParametersToJSON(json);
 }
@@ -123,9 +143,21 @@ bool AtlasECDriver::takeMeasurement()
     }
 }
 
+uint32 AtlasECDriver::measurementReadyAt()
+{
+  // the board converts on its own, the next reading is due one interval after the last
+  uint32 nextReading = lastSuccessfulReadingMillis + EC_READING_INTERVAL_MILLIS;
+  if ((long) (nextReading - millis()) > EC_READING_INTERVAL_MILLIS)
+  {
+    return millis();
+  }
+  return nextReading;
+}
+
 unsigned int AtlasECDriver::millisecondsUntilNextReadingAvailable()
 {
-  return 640 - (millis() - lastSuccessfulReadingMillis);
+  long remaining = (long) (measurementReadyAt() - millis());
+  return remaining > 0 ? remaining : 0;
 }
 
 const char * AtlasECDriver::getRawDataString()
@@ -134,6 +166,12 @@ const char * AtlasECDriver::getRawDataString()
   return dataString;
 }
 
+unsigned short AtlasECDriver::getRawValues(float * values)
+{
+  values[0] = value;
+  return 1;
+}
+
 const char * AtlasECDriver::getSummaryDataString()
 {
   sprintf(dataString, "%0.2f", getBurstSummaryMean(EC_TAG));
@@ -171,8 +209,8 @@ void AtlasECDriver::calibrationStep(char * step, int arg_cnt, char ** args)
   }
 }
 
-void AtlasECDriver::addCalibrationParametersToJSON(cJSON * json)
+void AtlasECDriver::addCalibrationParametersToJSON(JSONWriter &json)
 {
-  cJSON_AddNumberToObject(json, CALIBRATION_TIME_STRING, configuration.cal_timestamp);
+  json.addInteger(CALIBRATION_TIME_STRING, configuration.cal_timestamp);
 }
 
@@ -22,6 +22,9 @@
 #include "EC_OEM.h"
 
 #define ATLAS_EC_OEM_TYPE_STRING "atlas_ec"
+#define EC_READING_INTERVAL_MILLIS 640 // the OEM board converts continuously while awake
+#define EC_HIBERNATE_BREAK_EVEN_MILLIS 5000
+#define EC_WAKE_LATENCY_MILLIS 1000 // first reading after waking takes one conversion
 
 class AtlasECDriver : public I2CProtocolSensorDriver
 {
@@ -38,7 +41,8 @@ class AtlasECDriver : public I2CProtocolSensorDriver
   private:
     const char *sensorTypeString = ATLAS_EC_OEM_TYPE_STRING;
     driver_configuration configuration;
-    EC_OEM *oem_ec; // A pointer to the I2C driver for the Atlas EC sensor
+    EC_OEM *oem_ec = NULL; // the I2C driver for the Atlas EC sensor, constructed in oemStorage on the first setup()
+    alignas(EC_OEM) byte oemStorage[sizeof(EC_OEM)];
     
     int value;
     const char * baseColumnHeaders = "ec.mS";
@@ -55,24 +59,28 @@ class AtlasECDriver : public I2CProtocolSensorDriver
 
     void wake();
     void hibernate();
+    unsigned int hibernateBreakEvenMilliseconds();
+    unsigned int wakeLatencyMilliseconds();
     void setDebugMode(bool debug); // for setting internal debug parameters, such as LED on 
 
     bool takeMeasurement();
+    uint32 measurementReadyAt();
     const char * getRawDataString();
+    unsigned short getRawValues(float * values);
     const char * getSummaryDataString();
     const char * getBaseColumnHeaders();
 
     void initCalibration();
     void calibrationStep(char * step, int arg_cnt, char ** args);
-    void addCalibrationParametersToJSON(cJSON * json);
+    void addCalibrationParametersToJSON(JSONWriter &json);
 
     unsigned int millisecondsUntilNextReadingAvailable();
 
   protected:
     void configureSpecificConfigurationsFromBytes(configuration_bytes_partition configurations);
     configuration_bytes_partition getDriverSpecificConfigurationBytes();
-    // bool configureDriverFromJSON(cJSON *json);
-    void appendDriverSpecificConfigurationJSON(cJSON *json);
+    // bool configureDriverFromJSON(JSONReader &json);
+    void appendDriverSpecificConfigurationJSON(JSONWriter &json);
     void setDriverDefaults();
 };
 
@@ -23,7 +23,7 @@ configuration_bytes_partition DriverTemplate::getDriverSpecificConfigurationByte
   return partition;
 }
 
-bool DriverTemplate::configureDriverFromJSON(cJSON *json)
+bool DriverTemplate::configureDriverFromJSON(JSONReader &json)
 {
   return true;
 }
@@ -34,7 +34,7 @@ void DriverTemplate::configureSpecificConfigurationsFromBytes(configuration_byte
   memcpy(&configuration, &configurationPartition, sizeof(driver_configuration));
 }
 
-void DriverTemplate::appendDriverSpecificConfigurationJSON(cJSON * json)
+void DriverTemplate::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
   // debug("appeding driver specific driver template json");
   
@@ -74,6 +74,13 @@ const char *DriverTemplate::getRawDataString()
   return dataString;
 }
 
+unsigned short DriverTemplate::getRawValues(float * values)
+{
+  values[0] = value;
+  values[1] = value*31.83;
+  return 2;
+}
+
 const char *DriverTemplate::getSummaryDataString()
 {
   double burstSummaryMean = getBurstSummaryMean(VAR_TAG);
@@ -99,11 +106,11 @@ void DriverTemplate::calibrationStep(char *step, int arg_cnt, char ** args)
   // debug("driver template calibration steps");
 }
 
-void DriverTemplate::addCalibrationParametersToJSON(cJSON *json)
+void DriverTemplate::addCalibrationParametersToJSON(JSONWriter &json)
 {
   // follows structure of calibration parameters in .h
   // debug("add driver template calibration parameters to json");
-  cJSON_AddNumberToObject(json, CALIBRATION_TIME_STRING, configuration.cal_timestamp);
+  json.addInteger(CALIBRATION_TIME_STRING, configuration.cal_timestamp);
 }
 
 void DriverTemplate::setDriverDefaults()
@@ -44,6 +44,7 @@ class DriverTemplate : public DriverTemplateProtocolSensorDriver
     void stop();
     bool takeMeasurement();
     const char * getRawDataString();
+    unsigned short getRawValues(float * values);
     const char * getSummaryDataString();
     const char * getBaseColumnHeaders();
     void initCalibration();
@@ -52,8 +53,8 @@ class DriverTemplate : public DriverTemplateProtocolSensorDriver
   protected:
     void configureSpecificConfigurationsFromBytes(configuration_bytes_partition configurations);
     configuration_bytes_partition getDriverSpecificConfigurationBytes();
-    bool configureDriverFromJSON(cJSON *json);
-    void appendDriverSpecificConfigurationJSON(cJSON *json);
+    bool configureDriverFromJSON(JSONReader &json);
+    void appendDriverSpecificConfigurationJSON(JSONWriter &json);
     void setDriverDefaults();
 
   private:
@@ -67,7 +68,7 @@ class DriverTemplate : public DriverTemplateProtocolSensorDriver
     const char *baseColumnHeaders = "raw,cal"; // will be written to .csv
     char dataString[16]; // will be written to .csv
 
-    void addCalibrationParametersToJSON(cJSON *json);
+    void addCalibrationParametersToJSON(JSONWriter &json);
 };
 
 #endif
\ No newline at end of file
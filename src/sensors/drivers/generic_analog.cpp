@@ -23,6 +23,7 @@
 #include "system/clock.h"  // TODO: ideally not included in this scope
 #include "sensors/sensor_map.h"
 #include "system/hardware.h"
+#include "system/idle.h"
 #include "utilities/rrivmath.h"
 
 int ADC_PINS[5] = {
@@ -44,18 +45,18 @@ const char * GenericAnalogDriver::getSensorTypeString()
   return sensorTypeString;
 }
 
-bool GenericAnalogDriver::configureDriverFromJSON(cJSON *json)
+bool GenericAnalogDriver::configureDriverFromJSON(JSONReader &json)
 {
-  const cJSON *adcSelectJSON = cJSON_GetObjectItemCaseSensitive(json, "adc_select");
+  char adcSelect[10];
   const char * errorMessage = reinterpret_cast<const char *>(F("Invalid adc select"));
   bool error = false;
-  if (adcSelectJSON != NULL && cJSON_IsString(adcSelectJSON))
+  if (json.getString("adc_select", adcSelect, sizeof(adcSelect)))
   {
-    if (strcmp(adcSelectJSON->valuestring, "internal") == 0)
+    if (strcmp(adcSelect, "internal") == 0)
     {
       configurations.adc_select = ADC_SELECT_INTERNAL;
     }
-    else if (strcmp(adcSelectJSON->valuestring, "external") == 0)
+    else if (strcmp(adcSelect, "external") == 0)
     {
       configurations.adc_select = ADC_SELECT_EXTERNAL;
     }
@@ -74,15 +75,15 @@ bool GenericAnalogDriver::configureDriverFromJSON(cJSON *json)
     return false;
   }
 
-  const cJSON *sensorPortJSON = cJSON_GetObjectItemCaseSensitive(json, "sensor_port");
+  long sensorPort;
   int maxSensorPorts = 4; // External has 4 channels
   if (configurations.adc_select == ADC_SELECT_INTERNAL)
   {
     maxSensorPorts++;
   }
-  if (sensorPortJSON != NULL && cJSON_IsNumber(sensorPortJSON) && sensorPortJSON->valueint > 0 && sensorPortJSON->valueint <= maxSensorPorts)
+  if (json.getInteger("sensor_port", &sensorPort) && sensorPort > 0 && sensorPort <= maxSensorPorts)
   {
-    configurations.sensor_port = (byte)sensorPortJSON->valueint - 1;
+    configurations.sensor_port = (byte)sensorPort - 1;
   }
   else
   {
@@ -119,16 +120,16 @@ void GenericAnalogDriver::configureSpecificConfigurationsFromBytes(configuration
 }
 
 
-void GenericAnalogDriver::appendDriverSpecificConfigurationJSON(cJSON * json)
+void GenericAnalogDriver::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
-  cJSON_AddNumberToObject(json, "sensor_port", configurations.sensor_port + 1);
+  json.addInteger("sensor_port", configurations.sensor_port + 1);
   switch (configurations.adc_select)
   {
   case ADC_SELECT_INTERNAL:
-    cJSON_AddStringToObject(json, "adc_select", "internal");
+    json.addString("adc_select", "internal");
     break;
   case ADC_SELECT_EXTERNAL:
-    cJSON_AddStringToObject(json, "adc_select", "external");
+    json.addString("adc_select", "external");
     break;
   default:
     break;
@@ -157,6 +158,15 @@ void GenericAnalogDriver::stop()
   // notify("ADC port stopped");
 }
 
+unsigned short GenericAnalogDriver::getPowerDomains()
+{
+  if (configurations.adc_select == ADC_SELECT_EXTERNAL)
+  {
+    return POWER_DOMAIN_SWITCHED | POWER_DOMAIN_EXTERNAL_ADC;
+  }
+  return POWER_DOMAIN_SWITCHED;
+}
+
 bool GenericAnalogDriver::takeMeasurement()
 {
   // take measurement and write to dataString member variable
@@ -213,7 +223,7 @@ void GenericAnalogDriver::takeCalibrationBurstMeasurement()
     notify(this->value);
     sum += this->value;
     x[i] = this->value;
-    delay(100);
+    idle(100);
   }
   double average = (double) sum / configurations.calibrationBurstCount;
   this->value = average;
@@ -241,6 +251,13 @@ const char *GenericAnalogDriver::getRawDataString() //TODO: getRawDataString() ?
   return dataString;
 }
 
+unsigned short GenericAnalogDriver::getRawValues(float *values)
+{
+  values[0] = value;
+  values[1] = getCalibratedValue(value);
+  return 2;
+}
+
 const char *GenericAnalogDriver::getSummaryDataString()
 {
   double burstSummaryMean = getBurstSummaryMean(GENERIC_ANALOG_VALUE_TAG);
@@ -327,15 +344,15 @@ void GenericAnalogDriver::calibrationStep(char *step, int arg_cnt, char ** args)
     computeCalibratedCurve();
     setConfigurationNeedsSave();
 
-    cJSON *json = cJSON_CreateObject();
+    char string[200];
+    JSONWriter json(string, sizeof(string));
     addCalibrationParametersToJSON(json);
-    char *string = cJSON_Print(json);
-    if (string == NULL)
+    if (!json.finish())
     {
       notify("Print json fail");
+      return;
     }
     notify(string);
-    free(json);
   }
   else if(strcmp(step, "set-cal-burst-length") == 0)
   {
@@ -395,25 +412,25 @@ short GenericAnalogDriver::getOrderOfMagnitudeToScale()
   return exponent;
 }
 
-void GenericAnalogDriver::addCalibrationParametersToJSON(cJSON *json)
+void GenericAnalogDriver::addCalibrationParametersToJSON(JSONWriter &json)
 {
   if(configurations.order_of_magnitude > -6 && configurations.order_of_magnitude < 6)
   {  
-    cJSON_AddNumberToObject(json, "m", configurations.m);
-    cJSON_AddNumberToObject(json, "b", configurations.b);
-    // cJSON_AddNumberToObject(json, "order_of_magnitude", configuration.order_of_magnitude);
-    cJSON_AddNumberToObject(json, "x1", configurations.x1);
-    cJSON_AddNumberToObject(json, "x1 var", configurations.x1Var);
-    cJSON_AddNumberToObject(json, "x2", configurations.x2);
-    cJSON_AddNumberToObject(json, "x2 var", configurations.x2Var);
-    cJSON_AddNumberToObject(json, "cal burst length", configurations.calibrationBurstCount);
-    cJSON_AddNumberToObject(json, "y1", configurations.y1 * rrivmath::power(10, -getOrderOfMagnitudeToScale()));
-    cJSON_AddNumberToObject(json, "y2", configurations.y2 * rrivmath::power(10, -getOrderOfMagnitudeToScale()));
-    cJSON_AddNumberToObject(json, CALIBRATION_TIME_STRING, configurations.cal_timestamp);
+    json.addNumber("m", configurations.m);
+    json.addNumber("b", configurations.b);
+    // json.addInteger("order_of_magnitude", configuration.order_of_magnitude);
+    json.addInteger("x1", configurations.x1);
+    json.addInteger("x1 var", configurations.x1Var);
+    json.addInteger("x2", configurations.x2);
+    json.addInteger("x2 var", configurations.x2Var);
+    json.addInteger("cal burst length", configurations.calibrationBurstCount);
+    json.addNumber("y1", configurations.y1 * rrivmath::power(10, -getOrderOfMagnitudeToScale()));
+    json.addNumber("y2", configurations.y2 * rrivmath::power(10, -getOrderOfMagnitudeToScale()));
+    json.addInteger(CALIBRATION_TIME_STRING, configurations.cal_timestamp);
   }
   else
   {
-    cJSON_AddStringToObject(json, "calibration", "not init");
+    json.addString("calibration", "not init");
   }
 }
 
@@ -79,8 +79,10 @@ public:
   const char *getSensorTypeString();
   void setup();
   void stop();
+  unsigned short getPowerDomains();
   bool takeMeasurement();
   const char *getRawDataString();
+  unsigned short getRawValues(float *values);
   const char *getSummaryDataString();
   const char *getBaseColumnHeaders();
 
@@ -92,12 +94,12 @@ public:
 protected:
   void configureSpecificConfigurationsFromBytes(configuration_bytes_partition configurations);
   configuration_bytes_partition getDriverSpecificConfigurationBytes();
-  bool configureDriverFromJSON(cJSON *json);
-  void appendDriverSpecificConfigurationJSON(cJSON *json);
+  bool configureDriverFromJSON(JSONReader &json);
+  void appendDriverSpecificConfigurationJSON(JSONWriter &json);
   void setDriverDefaults();
 
 private:
-  void addCalibrationParametersToJSON(cJSON *json);
+  void addCalibrationParametersToJSON(JSONWriter &json);
 };
 
 #endif
\ No newline at end of file
@@ -1,42 +1,63 @@
 #include "registry.h"
 #include "sensors/sensor_map.h"
-#include "system/logs.h"
 //
 // Follow steps to add a new sensor driver
 //
 
 // Step 1: Include the header for your driver in registry.h
 
+template <unsigned short Code>
+struct RegisteredDriver
+{
+  static constexpr driver_registration_type registration() { return { NULL, NULL }; }
+};
 
-#define GENERIC_ANALOG_SENSOR 0x0000
-#define ATLAS_EC_OEM_SENSOR 0x0001
-#define ADAFRUIT_DHT22_SENSOR 0x0002
-#define ATLAS_CO2_SENSOR 0x0003
-// Step 2: Add a #define for the next available integer code
+#define REGISTER_DRIVER(code, driverClass, typeString) \
+  template <> \
+  struct RegisteredDriver<code> \
+  { \
+    static_assert(code < SENSOR_TYPE_TABLE_SIZE, "raise SENSOR_TYPE_TABLE_SIZE"); \
+    static constexpr driver_registration_type registration() { return { typeString, &createInstance<driverClass> }; } \
+  };
 
-#define DRIVER_TEMPLATE 0xFFFE
-#define NO_SENSOR 0xFFFF
+REGISTER_DRIVER(GENERIC_ANALOG_SENSOR, GenericAnalogDriver, GENERIC_ANALOG_DRIVER_TYPE_STRING)
 
+// REGISTER_DRIVER(ATLAS_EC_OEM_SENSOR, AtlasECDriver, ATLAS_EC_OEM_TYPE_STRING)
 
+REGISTER_DRIVER(ADAFRUIT_DHT22_SENSOR, AdaDHT22, ADAFRUIT_DHT22_TYPE_STRING)
 
-void buildDriverSensorMap()
-{  
+// REGISTER_DRIVER(ATLAS_CO2_SENSOR, AtlasCO2Driver, ATLAS_CO2_DRIVER_TYPE_STRING)
 
-  setupSensorMaps<GenericAnalogDriver>(GENERIC_ANALOG_SENSOR, F(GENERIC_ANALOG_DRIVER_TYPE_STRING));
+// Step 3: call REGISTER_DRIVER with the code, class name, and type string for your sensor
+// REGISTER_DRIVER($SENSOR_CODE, $CLASS_NAME, $SENSOR_STRING_NAME)
+// $SENSOR_CODE is the define added in step 2 above for this sensor
+// $CLASS_NAME is the C++ class of the sensor
+// $SENSOR_STRING_NAME is the define for human readable sensor name found in the .h for this sensor driver
 
-  // setupSensorMaps<AtlasECDriver>(ATLAS_EC_OEM_SNSOR, F(ATLAS_EC_OEM_TYPE_STRING));
 
-  // setupSensorMaps<DriverTemplate>(DRIVER_TEMPLATE, F(DRIVER_TEMPLATE_TYPE_STRING));
- 
-  setupSensorMaps<AdaDHT22>(ADAFRUIT_DHT22_SENSOR, F(ADAFRUIT_DHT22_TYPE_STRING));
+// Expands RegisteredDriver<0> ... RegisteredDriver<SENSOR_TYPE_TABLE_SIZE - 1> into one constant array
+template <unsigned short... Codes>
+struct CodeList {};
 
-  // setupSensorMaps<AtlasCO2Driver>(ATLAS_CO2_SENSOR, F(ATLAS_CO2_DRIVER_TYPE_STRING));
+template <unsigned short Count, unsigned short... Codes>
+struct MakeCodeList : MakeCodeList<Count - 1, Count - 1, Codes...> {};
 
-  // Step 3: call setupSensorMaps with the class name, code, and type string for your sensor
-  // setupSensorMaps<$CLASS_NAME>($SENSOR_CODE, F($SENSOR_STRING_NAME));
-  // $CLASS_NAME is the C++ class of the sensor
-  // $SENSOR_CODE is the define added in step 2 above for this sensor
-  // $SENSOR_STRING_NAME is the define for human readable sensor name found in the .h for this sensor driver
+template <unsigned short... Codes>
+struct MakeCodeList<0, Codes...>
+{
+  typedef CodeList<Codes...> type;
+};
 
+template <class List>
+struct RegistryTable;
 
-}
+template <unsigned short... Codes>
+struct RegistryTable<CodeList<Codes...> >
+{
+  static constexpr driver_registration_type entries[sizeof...(Codes)] = { RegisteredDriver<Codes>::registration()... };
+};
+
+template <unsigned short... Codes>
+constexpr driver_registration_type RegistryTable<CodeList<Codes...> >::entries[sizeof...(Codes)];
+
+const driver_registration_type * const driverRegistry = RegistryTable<MakeCodeList<SENSOR_TYPE_TABLE_SIZE>::type>::entries;
@@ -8,6 +8,26 @@
 
 #define MAX_SENSOR_TYPE 0xFFFE
 
-void buildDriverSensorMap();
+// Type codes are stored in each slot's EEPROM configuration, don't renumber them
+#define GENERIC_ANALOG_SENSOR 0x0000
+#define ATLAS_EC_OEM_SENSOR 0x0001
+#define ADAFRUIT_DHT22_SENSOR 0x0002
+#define ATLAS_CO2_SENSOR 0x0003
+// Step 2: Add a #define for the next available integer code, and raise SENSOR_TYPE_TABLE_SIZE past it
 
-#endif
\ No newline at end of file
+#define DRIVER_TEMPLATE 0xFFFE // outside the table, register the template under a free code to try it
+#define NO_SENSOR 0xFFFF
+
+#define SENSOR_TYPE_TABLE_SIZE 4 // one entry per code from 0, registered or not
+
+typedef struct driver_registration
+{
+  const char * typeString;
+  SensorDriver * (*create)();
+} driver_registration_type;
+
+// Built at compile time in registry.cpp and kept in flash, indexed by type code.
+// Unregistered codes have NULL entries.
+extern const driver_registration_type * const driverRegistry;
+
+#endif
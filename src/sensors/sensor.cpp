@@ -24,21 +24,23 @@
 SensorDriver::SensorDriver(){}
 SensorDriver::~SensorDriver(){}
 
-cJSON *SensorDriver::getConfigurationJSON() // returns unprotected pointer
-{
-  cJSON *json = cJSON_CreateObject();
-  cJSON_AddNumberToObject(json, "slot", commonConfigurations.slot + 1);
-  cJSON_AddStringToObject(json, "type", getSensorTypeString());
-  cJSON_AddStringToObject(json, "tag", commonConfigurations.tag);
-  cJSON_AddNumberToObject(json, "burst_size", commonConfigurations.burst_size);
+void SensorDriver::getConfigurationJSON(JSONWriter &json)
+{
+  json.addInteger("slot", commonConfigurations.slot + 1);
+  json.addString("type", getSensorTypeString());
+  json.addString("tag", commonConfigurations.tag);
+  json.addInteger("burst_size", commonConfigurations.burst_size);
+  json.addInteger("interval_seconds", commonConfigurations.interval);
+  json.addInteger("offset_seconds", commonConfigurations.offset);
+  json.addInteger("burst_number", commonConfigurations.burst_number);
   this->appendDriverSpecificConfigurationJSON(json);
-  return json;
 }
 
 const configuration_bytes SensorDriver::getConfigurationBytes()
 {
   configuration_bytes configurationBytes;
-  memcpy(&configurationBytes.common, &commonConfigurations, sizeof(configuration_bytes_partition));
+  memset(&configurationBytes.common, 0, sizeof(configuration_bytes_partition));
+  memcpy(&configurationBytes.common, &commonConfigurations, sizeof(common_sensor_driver_config));
   configuration_bytes_partition driverSpecificPartition = getDriverSpecificConfigurationBytes();
   memcpy(&configurationBytes.specific, &driverSpecificPartition, sizeof(configuration_bytes_partition));
   return configurationBytes;
@@ -61,13 +63,13 @@ configuration_bytes_partition SensorDriver::getDriverSpecificConfigurationBytes(
   return emptyPartition;
 }
 
-bool SensorDriver::configureDriverFromJSON(cJSON *json)
+bool SensorDriver::configureDriverFromJSON(JSONReader &json)
 {
   // override to load driver specific configurations
   return true;
 }
   
-void SensorDriver::appendDriverSpecificConfigurationJSON(cJSON * json)
+void SensorDriver::appendDriverSpecificConfigurationJSON(JSONWriter &json)
 {
   // override to return driver specific configurations
 }
@@ -75,8 +77,7 @@ void SensorDriver::appendDriverSpecificConfigurationJSON(cJSON * json)
 void SensorDriver::initializeBurst()
 {
   burstCount = 0;
-  burstSummarySumCounts.clear();
-  burstSummarySums.clear();
+  burstSummaryCount = 0;
 }
 
 void SensorDriver::incrementBurst()
@@ -91,20 +92,38 @@ bool SensorDriver::burstCompleted()
   return burstCount >= commonConfigurations.burst_size;
 }
 
-void SensorDriver::addValueToBurstSummaryMean(std::string tag, double value)
+void SensorDriver::addValueToBurstSummaryMean(const char * tag, double value)
 {
-  if(burstSummarySums.count(tag) == 0)
+  unsigned short i = 0;
+  while (i < burstSummaryCount && strcmp(burstSummaries[i].tag, tag) != 0)
+  {
+    i++;
+  }
+  if (i == burstSummaryCount)
   {
-    burstSummarySums[tag] = 0;
-    burstSummarySumCounts[tag] = 0;
+    if (burstSummaryCount == BURST_SUMMARY_TAG_COUNT)
+    {
+      return;
+    }
+    burstSummaries[i].tag = tag;
+    burstSummaries[i].sum = 0;
+    burstSummaries[i].count = 0;
+    burstSummaryCount++;
   }
-  burstSummarySums[tag] += value;
-  burstSummarySumCounts[tag] += 1;
+  burstSummaries[i].sum += value;
+  burstSummaries[i].count += 1;
 }
 
-double SensorDriver::getBurstSummaryMean(std::string tag)
+double SensorDriver::getBurstSummaryMean(const char * tag)
 {
-  return burstSummarySums[tag] / burstSummarySumCounts[tag];
+  for (unsigned short i = 0; i < burstSummaryCount; i++)
+  {
+    if (strcmp(burstSummaries[i].tag, tag) == 0)
+    {
+      return burstSummaries[i].sum / burstSummaries[i].count;
+    }
+  }
+  return 0;
 }
 
 void SensorDriver::configureCSVColumns()
@@ -142,11 +161,19 @@ void SensorDriver::setDefaults()
   {
     commonConfigurations.burst_size = 10;
   }
+  if(commonConfigurations.interval > MAX_SENSOR_INTERVAL)
+  {
+    commonConfigurations.interval = 0;
+  }
+  if(commonConfigurations.burst_number > 20)
+  {
+    commonConfigurations.burst_number = 0;
+  }
   this->setDriverDefaults();
 }
 
 
-bool SensorDriver::configureFromJSON(cJSON * json)
+bool SensorDriver::configureFromJSON(JSONReader &json)
 {
   
 #ifndef PRODUCTION_FIRMWARE_BUILD
@@ -160,14 +187,14 @@ bool SensorDriver::configureFromJSON(cJSON * json)
   }
 #endif
 
-  memset(&commonConfigurations, 0, SENSOR_CONFIGURATION_SIZE);
+  memset(&commonConfigurations, 0, sizeof(common_sensor_driver_config));
 
   commonConfigurations.sensor_type = typeCodeForSensorTypeString(getSensorTypeString());
 
-  const cJSON* slotJSON = cJSON_GetObjectItemCaseSensitive(json, "slot");
-  if(slotJSON != NULL && cJSON_IsNumber(slotJSON) && slotJSON->valueint > 0 && slotJSON->valueint <= EEPROM_TOTAL_SENSOR_SLOTS)
+  long slot;
+  if(json.getInteger("slot", &slot) && slot > 0 && slot <= EEPROM_TOTAL_SENSOR_SLOTS)
   {
-    commonConfigurations.slot = slotJSON->valueint - 1;
+    commonConfigurations.slot = slot - 1;
   }
   else
   {
@@ -175,21 +202,16 @@ bool SensorDriver::configureFromJSON(cJSON * json)
     return false;
   }
 
-  const cJSON * tagJSON = cJSON_GetObjectItemCaseSensitive(json, "tag");
-  if(tagJSON != NULL && cJSON_IsString(tagJSON) && strlen(tagJSON->valuestring) <= 5)
-  {
-    strcpy(commonConfigurations.tag, tagJSON->valuestring);
-  }
-  else
+  if(!json.getString("tag", commonConfigurations.tag, sizeof(commonConfigurations.tag))) // 5 characters
   {
     notify("Invalid tag");
     return false;
   }
 
-  const cJSON * burstSizeJson = cJSON_GetObjectItemCaseSensitive(json, "burst_size");
-  if(burstSizeJson != NULL && cJSON_IsNumber(burstSizeJson) && burstSizeJson->valueint > 0)
+  long burstSize;
+  if(json.getInteger("burst_size", &burstSize) && burstSize > 0)
   {
-    commonConfigurations.burst_size = (byte) burstSizeJson->valueint;
+    commonConfigurations.burst_size = (byte) burstSize;
   }
   else
   {
@@ -197,6 +219,49 @@ bool SensorDriver::configureFromJSON(cJSON * json)
     return false;
   }
 
+  // optional per slot schedule, defaults to the datalogger schedule
+  long interval;
+  if(json.has("interval_seconds"))
+  {
+    if(json.getInteger("interval_seconds", &interval) && interval >= 0 && interval <= MAX_SENSOR_INTERVAL)
+    {
+      commonConfigurations.interval = (unsigned long) interval;
+    }
+    else
+    {
+      notify("Invalid interval");
+      return false;
+    }
+  }
+
+  long offset;
+  if(json.has("offset_seconds"))
+  {
+    if(json.getInteger("offset_seconds", &offset) && offset >= 0 && offset <= 65535)
+    {
+      commonConfigurations.offset = (unsigned short) offset;
+    }
+    else
+    {
+      notify("Invalid offset");
+      return false;
+    }
+  }
+
+  long burstNumber;
+  if(json.has("burst_number"))
+  {
+    if(json.getInteger("burst_number", &burstNumber) && burstNumber >= 0 && burstNumber <= 20)
+    {
+      commonConfigurations.burst_number = (byte) burstNumber;
+    }
+    else
+    {
+      notify("Invalid burst number");
+      return false;
+    }
+  }
+
   this->setDefaults();
   if (this->configureDriverFromJSON(json) == false)
   {
@@ -211,7 +276,14 @@ void SensorDriver::configureFromBytes(configuration_bytes configurationBytes)
 {
   configuration_bytes_partition partitions[2];
   memcpy(&partitions, &configurationBytes, sizeof(configuration_bytes));
-  memcpy(&commonConfigurations, &partitions[0], sizeof(configuration_bytes_partition));
+  memcpy(&commonConfigurations, &partitions[0], sizeof(common_sensor_driver_config));
+  if(commonConfigurations.interval > MAX_SENSOR_INTERVAL || commonConfigurations.burst_number > 20)
+  {
+    // slots stored before schedules existed have arbitrary bytes here
+    commonConfigurations.interval = 0;
+    commonConfigurations.offset = 0;
+    commonConfigurations.burst_number = 0;
+  }
   this->configureSpecificConfigurationsFromBytes(partitions[1]);
   this->configureCSVColumns();
 }
@@ -237,16 +309,56 @@ void SensorDriver::wake()
 
 }
 
+unsigned int SensorDriver::hibernateBreakEvenMilliseconds()
+{
+  return 0; // no standby by default
+}
+
+unsigned int SensorDriver::wakeLatencyMilliseconds()
+{
+  return 0;
+}
+
+unsigned short SensorDriver::getPowerDomains()
+{
+  return POWER_DOMAIN_SWITCHED;
+}
+
 void SensorDriver::setDebugMode(bool debug) // for setting internal debug parameters, such as LED on
 {
 
 }
 
+void SensorDriver::startMeasurement()
+{
+  measurementStartedAt = millis();
+}
+
+uint32 SensorDriver::measurementReadyAt()
+{
+  return measurementStartedAt;
+}
+
+bool SensorDriver::collectMeasurement()
+{
+  return takeMeasurement();
+}
+
 bool SensorDriver::isWarmedUp()
 {
   return true;
 }
 
+unsigned int SensorDriver::millisecondsUntilWarmedUp(uint32 millisecondsSinceSetup)
+{
+  uint32 warmupMilliseconds = (uint32) commonConfigurations.warmup * 1000;
+  if (millisecondsSinceSetup >= warmupMilliseconds)
+  {
+    return 0;
+  }
+  return warmupMilliseconds - millisecondsSinceSetup;
+}
+
 short SensorDriver::getSlot()
 {
   return commonConfigurations.slot;
@@ -293,6 +405,11 @@ protocol_type I2CProtocolSensorDriver::getProtocol()
   return i2c;
 }
 
+unsigned short I2CProtocolSensorDriver::getPowerDomains()
+{
+  return POWER_DOMAIN_SWITCHED | POWER_DOMAIN_I2C2;
+}
+
 void I2CProtocolSensorDriver::setWire(TwoWire * wire)
 {
   this->wire = wire;
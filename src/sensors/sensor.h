@@ -21,9 +21,10 @@
 
 #include <Arduino.h>
 #include <Wire_slave.h>
-#include <cJSON.h>
+#include "utilities/json.h"
 #include <map>
 #include <string>
+#include "system/power_domains.h"
 
 #define CALIBRATION_TIME_STRING reinterpret_cast<const char*>(F("calibration_time"))
 
@@ -36,6 +37,8 @@ typedef enum protocol
 } protocol_type;
 
 #define SENSOR_CONFIGURATION_SIZE 64
+#define BURST_SUMMARY_TAG_COUNT 4 // values a driver averages over a burst
+#define SENSOR_MAX_RAW_VALUES 4   // getRawValues()
 
 typedef struct 
 { 
@@ -52,7 +55,7 @@ typedef struct
 // common_sensor_driver_config
 // configurations shared between all drivers
 // needs to be 32 bytes total (one configuration_partition_bytes)
-// 20 bytes currently usused
+// 12 bytes currently usused
 typedef struct
 {
   // arrange from biggest type to smallest type
@@ -61,9 +64,14 @@ typedef struct
   unsigned short int warmup;      // 2 bytes - in seconds (65535 max value/60=1092 min)
   byte slot;                      // 1 byte
   byte burst_size;                // 1 byte
+  unsigned long interval;         // 4 bytes - in seconds, 0 uses the datalogger interval
+  unsigned short int offset;      // 2 bytes - in seconds after the interval boundary
+  byte burst_number;              // 1 byte - bursts per wake, 0 uses the datalogger burst number
 
 } common_sensor_driver_config;
 
+#define MAX_SENSOR_INTERVAL 86400 // seconds, once a day
+
 
 #define MAX_REQUESTED_READING_DELAY 3600000;
 
@@ -74,7 +82,7 @@ public:
   // Constructor
   SensorDriver();
   virtual ~SensorDriver();
-  bool configureFromJSON(cJSON *json);
+  bool configureFromJSON(JSONReader &json);
   void configureFromBytes(configuration_bytes configurationBytes); 
   const configuration_bytes getConfigurationBytes();
   const common_sensor_driver_config * getCommonConfigurations();
@@ -85,11 +93,11 @@ public:
   bool burstCompleted();
 
   // utility function for providing mean for burst summary value
-  void addValueToBurstSummaryMean(std::string tag, double value);
-  double getBurstSummaryMean(std::string tag);
+  void addValueToBurstSummaryMean(const char * tag, double value);
+  double getBurstSummaryMean(const char * tag);
 
   char *getCSVColumnHeaders();
-  cJSON *getConfigurationJSON(); // returns unprotected pointer
+  void getConfigurationJSON(JSONWriter &json); // the caller finishes the object
 
   short getSlot();
   void setConfigurationNeedsSave();
@@ -99,16 +107,23 @@ public:
 
 protected:
   common_sensor_driver_config commonConfigurations;
+  uint32 measurementStartedAt = 0; // millis() when startMeasurement() was called
   void configureCSVColumns();
 
 private:
-  char csvColumnHeaders[200] = "column_header";
+  char csvColumnHeaders[100] = "column_header"; // as long as configureCSVColumns() builds
   short burstCount = 0;
   bool configurationNeedsSave = false;
 
-  // Variables for computing burst summary values
-  std::map<std::string, double> burstSummarySums;
-  std::map<std::string, int> burstSummarySumCounts;
+  // Variables for computing burst summary values, fixed so bursts don't allocate
+  typedef struct
+  {
+    const char * tag;
+    double sum;
+    int count;
+  } burst_summary;
+  burst_summary burstSummaries[BURST_SUMMARY_TAG_COUNT];
+  unsigned short burstSummaryCount = 0;
 
   //
   // Subclass Implementation Interface
@@ -137,9 +152,26 @@ public:
    */
   virtual void setup();
   virtual void stop();
+  virtual void setDebugMode(bool debug);
+
+  /*
+   *  Low power standby between bursts and samples, without losing setup().
+   *  Drivers that implement hibernate() and wake() also return the shortest
+   *  gap worth hibernating for, and how long before its next reading the
+   *  sensor must be woken.  A break even of 0 means the sensor is never
+   *  hibernated.
+   */
   virtual void hibernate();
   virtual void wake();
-  virtual void setDebugMode(bool debug);
+  virtual unsigned int hibernateBreakEvenMilliseconds();
+  virtual unsigned int wakeLatencyMilliseconds();
+
+  /*
+   *  Power domains (POWER_DOMAIN_* bits) this sensor needs while it is set up.
+   *  The datalogger switches them on before setup() and releases them after stop().
+   *  Defaults to the switched rail.
+   */
+  virtual unsigned short getPowerDomains();
 
   /*
    *  Retrieve a measurement from the sensor
@@ -153,6 +185,22 @@ public:
    */
   virtual bool takeMeasurement() = 0;
 
+  /*
+   *  Optional two phase measurement, so slow conversions on several sensors
+   *  run at the same time instead of one after another.
+   *
+   *  startMeasurement() triggers a conversion and returns immediately.
+   *  measurementReadyAt() returns the millis() time the result is expected.
+   *  collectMeasurement() reads and stores the result, with the same
+   *  return value as takeMeasurement().
+   *
+   *  By default nothing is started, the result is ready immediately and
+   *  collectMeasurement() calls takeMeasurement().
+   */
+  virtual void startMeasurement();
+  virtual uint32 measurementReadyAt();
+  virtual bool collectMeasurement();
+
 
 
 
@@ -165,6 +213,15 @@ public:
    */
   virtual const char *getRawDataString() = 0;
 
+  /*
+   * The values of getRawDataString() as numbers, for binary streaming
+   * without the text formatting.
+   *
+   * @param values room for SENSOR_MAX_RAW_VALUES
+   * @return how many values were written
+   */
+  virtual unsigned short getRawValues(float *values) = 0;
+
 
   virtual const char *getSummaryDataString() = 0;
 
@@ -180,6 +237,15 @@ public:
 
   virtual bool isWarmedUp();
 
+  /*
+   * Returns how much longer the sensor needs to warm up, so the datalogger
+   * can sleep instead of polling isWarmedUp().
+   * By default counts down the configured warmup seconds.
+   *
+   * @param millisecondsSinceSetup time since setup() powered the sensor, including time asleep
+   */
+  virtual unsigned int millisecondsUntilWarmedUp(uint32 millisecondsSinceSetup);
+
   // Calibration
   virtual void initCalibration() = 0;
   ;
@@ -196,9 +262,9 @@ protected:
   
   virtual configuration_bytes_partition getDriverSpecificConfigurationBytes() = 0;
 
-  virtual bool configureDriverFromJSON(cJSON *json);
+  virtual bool configureDriverFromJSON(JSONReader &json);
   
-  virtual void appendDriverSpecificConfigurationJSON(cJSON * json) = 0;
+  virtual void appendDriverSpecificConfigurationJSON(JSONWriter &json) = 0;
   
   virtual void setDriverDefaults() = 0;
 
@@ -215,6 +281,7 @@ class I2CProtocolSensorDriver : public SensorDriver
 public:
   ~I2CProtocolSensorDriver();
   protocol_type getProtocol();
+  unsigned short getPowerDomains();
   void setWire(TwoWire *wire);
 
 protected:
@@ -18,25 +18,41 @@
 
 #include "sensor_map.h"
 #include "Arduino.h"
+#include "sensors/drivers/registry.h"
 
-sensor_type_map_type sensorTypeMap;
-std::map<std::string, short> sensorTypeCodeMap;
+static const driver_registration_type * registrationForTypeCode(short type)
+{
+  unsigned short code = type;
+  if (code >= SENSOR_TYPE_TABLE_SIZE || driverRegistry[code].create == NULL)
+  {
+    return NULL;
+  }
+  return &driverRegistry[code];
+}
 
 bool sensorTypeCodeExists(short type)
 {
-  return sensorTypeMap.count(type) > 0;
+  return registrationForTypeCode(type) != NULL;
 }
 
 short typeCodeForSensorTypeString(const char * type)
 {
-  return sensorTypeCodeMap[std::string(type)];
+  for (unsigned short code = 0; code < SENSOR_TYPE_TABLE_SIZE; code++)
+  {
+    if (driverRegistry[code].typeString != NULL && strcmp(driverRegistry[code].typeString, type) == 0)
+    {
+      return code;
+    }
+  }
+  return (short) NO_SENSOR;
 }
 
 SensorDriver * driverForSensorTypeCode(short type)
 {
-  if(sensorTypeMap[type] == NULL)
+  const driver_registration_type * registration = registrationForTypeCode(type);
+  if (registration == NULL)
   {
     return NULL;
   }
-  return sensorTypeMap[type]();
+  return registration->create();
 }
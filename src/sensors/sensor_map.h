@@ -20,26 +20,23 @@
 #define WATERBEAR_SENSOR_MAP
 
 #include "sensor.h"
-#include <map>
+#include "driver_pool.h"
+#include <new>
 
-template<typename T> SensorDriver * createInstance() { return new T; }
-
-typedef std::map<short, SensorDriver*(*)()> sensor_type_map_type;
-
-extern sensor_type_map_type sensorTypeMap;
-extern std::map<std::string, short> sensorTypeCodeMap;
-
-template <class T>
-void setupSensorMaps(short sensorCode, __FlashStringHelper const * sensorTypeString )
+template<typename T> SensorDriver * createInstance()
 {
-  sensorTypeMap[sensorCode] = &createInstance<T>;
-  std::string sensorType( reinterpret_cast<const char *> (sensorTypeString) );
-  sensorTypeCodeMap[sensorType] = sensorCode;
+  static_assert(sizeof(T) <= DRIVER_POOL_CELL_SIZE, "driver does not fit a driver pool cell");
+  void * cell = allocateDriverCell();
+  if (cell == NULL)
+  {
+    return NULL;
+  }
+  return new (cell) T;
 }
 
-void buildDriverSensorMap();
+// Lookups in the driver registry, see sensors/drivers/registry.cpp
 bool sensorTypeCodeExists(short type);
-short typeCodeForSensorTypeString(const char * type);
-SensorDriver * driverForSensorTypeCode(short type);
+short typeCodeForSensorTypeString(const char * type); // NO_SENSOR when not registered
+SensorDriver * driverForSensorTypeCode(short type);   // NULL when not registered or the driver pool is full
 
 #endif
\ No newline at end of file
@@ -19,6 +19,7 @@
 #include "adc.h"
 #include <Wire_slave.h> // Communicate with I2C/TWI devices
 #include "system/logs.h"
+#include "system/serial_tx.h"
 #include "system/watchdog.h"
 #include "utilities/i2c.h"
 
@@ -162,8 +163,8 @@ void AD7091R::writeConfigurationRegister(configuration_register configurationReg
 {
   // debug(F("writing configuration register"));
   printConfigurationRegister(configurationRegister);
-  Serial2.println(  *((byte *) &configurationRegister+1), BIN);
-  Serial2.println(  *((byte *) &configurationRegister), BIN);
+  SerialOutput.println(  *((byte *) &configurationRegister+1), BIN);
+  SerialOutput.println(  *((byte *) &configurationRegister), BIN);
   this->sendTransmission(ADC_CONFIGURATION_REGISTER_ADDRESS, &configurationRegister, 2);
 }
 
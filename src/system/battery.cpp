@@ -0,0 +1,103 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "battery.h"
+#include "hardware.h"
+
+BatteryPolicy::BatteryPolicy()
+{
+  unsigned short disabled[BATTERY_TIER_COUNT] = {0};
+  configure(BATTERY_DEFAULT_FULL_SCALE_MILLIVOLTS, disabled);
+  trend = 0;
+  tier = 0;
+}
+
+void BatteryPolicy::configure(unsigned short fullScaleMillivolts, const unsigned short * tierMillivolts)
+{
+  this->fullScaleMillivolts = fullScaleMillivolts;
+  for (unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    this->tierMillivolts[i] = tierMillivolts[i];
+  }
+}
+
+unsigned short BatteryPolicy::readMillivolts()
+{
+  return (unsigned long) getBatteryValue() * fullScaleMillivolts / BATTERY_ADC_COUNTS;
+}
+
+bool BatteryPolicy::update()
+{
+  unsigned short millivolts = readMillivolts();
+  if (trend == 0)
+  {
+    trend = (unsigned long) millivolts << BATTERY_TREND_SHIFT;
+  }
+  else
+  {
+    trend = trend - (trend >> BATTERY_TREND_SHIFT) + millivolts;
+  }
+
+  unsigned short trendMillivolts = getTrendMillivolts();
+  unsigned short next = tier;
+  while (next < BATTERY_TIER_COUNT && tierMillivolts[next] > 0 && trendMillivolts < tierMillivolts[next])
+  {
+    next++;
+  }
+  while (next > 0 && trendMillivolts > tierMillivolts[next - 1] + BATTERY_TIER_HYSTERESIS_MILLIVOLTS)
+  {
+    next--;
+  }
+
+  bool changed = next != tier;
+  tier = next;
+  return changed;
+}
+
+unsigned short BatteryPolicy::getTier()
+{
+  return tier;
+}
+
+unsigned short BatteryPolicy::getTrendMillivolts()
+{
+  return trend >> BATTERY_TREND_SHIFT;
+}
+
+unsigned short BatteryPolicy::intervalMultiplier()
+{
+  if (tier >= 4)
+  {
+    return 4;
+  }
+  return tier >= 1 ? 2 : 1;
+}
+
+bool BatteryPolicy::rawLoggingAllowed()
+{
+  return tier < 2;
+}
+
+bool BatteryPolicy::singleBurst()
+{
+  return tier >= 3;
+}
+
+bool BatteryPolicy::batchWrites()
+{
+  return tier >= 4;
+}
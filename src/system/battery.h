@@ -0,0 +1,64 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_BATTERY
+#define WATERBEAR_BATTERY
+
+#include <Arduino.h>
+
+#define BATTERY_ADC_COUNTS 4096
+#define BATTERY_DEFAULT_FULL_SCALE_MILLIVOLTS 6600 // 3v3 reference behind a 1:2 divider, until calibrated
+#define BATTERY_TIER_COUNT 4
+#define BATTERY_TIER_HYSTERESIS_MILLIVOLTS 100 // recovering a tier needs this much above its threshold
+#define BATTERY_TREND_SHIFT 3 // each reading moves the trend 1/8 of the way
+#define BATTERY_BATCH_RESERVE_BYTES 500 // free write cache that forces the SD card to be mounted
+
+// Degradation tiers as the battery trend falls below each configured threshold.
+// Each tier keeps the savings of the tiers before it.
+//   0  normal
+//   1  sampling intervals doubled
+//   2  raw burst rows no longer logged
+//   3  a single burst per wake
+//   4  sampling intervals quadrupled, rows batched in the write cache between SD writes
+class BatteryPolicy
+{
+public:
+  BatteryPolicy();
+
+  // full scale is the battery voltage that reads as BATTERY_ADC_COUNTS
+  // a threshold of 0 disables that tier and the ones after it
+  void configure(unsigned short fullScaleMillivolts, const unsigned short * tierMillivolts);
+
+  unsigned short readMillivolts();
+  bool update(); // true when the tier changed
+
+  unsigned short getTier();
+  unsigned short getTrendMillivolts();
+
+  unsigned short intervalMultiplier();
+  bool rawLoggingAllowed();
+  bool singleBurst();
+  bool batchWrites();
+
+private:
+  unsigned short fullScaleMillivolts;
+  unsigned short tierMillivolts[BATTERY_TIER_COUNT];
+  unsigned long trend; // millivolts << BATTERY_TREND_SHIFT, 0 until the first reading
+  unsigned short tier;
+};
+
+#endif
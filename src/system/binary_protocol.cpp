@@ -0,0 +1,405 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "binary_protocol.h"
+#include "datalogger.h"
+#include "version.h"
+#include "utilities/crc.h"
+#include "system/logs.h"
+
+uint32 binaryReadLittleEndian(const void * data, byte count)
+{
+  const byte * bytes = (const byte *) data;
+  uint32 value = 0;
+  for(byte i = 0; i < count; i++)
+  {
+    value |= (uint32) bytes[i] << (8 * i);
+  }
+  return value;
+}
+
+void binaryWriteLittleEndian(byte * data, uint32 value, byte count)
+{
+  for(byte i = 0; i < count; i++)
+  {
+    data[i] = value >> (8 * i);
+  }
+}
+
+void writeBinaryFrame(Print &output, byte * packet, unsigned short length)
+{
+  binaryWriteLittleEndian(packet + length, crc16(packet, length), BINARY_CRC_LENGTH);
+  output.write((uint8) BINARY_SYNC);
+  cobsWrite(output, packet, length + BINARY_CRC_LENGTH);
+  output.write((uint8) BINARY_SYNC);
+}
+
+// a Print into a response body, for output written for the serial port
+class BodyPrint : public Print
+{
+public:
+  BodyPrint(byte * body, unsigned short capacity) : body(body), capacity(capacity) {}
+
+  size_t write(uint8 value)
+  {
+    if(length >= capacity)
+    {
+      overflowed = true;
+      return 0;
+    }
+    body[length++] = value;
+    return 1;
+  }
+  using Print::write;
+
+  byte * body;
+  unsigned short capacity;
+  unsigned short length = 0;
+  bool overflowed = false;
+};
+
+typedef struct directory_listing
+{
+  byte * body;
+  unsigned short capacity;
+  unsigned short length;
+  unsigned short index; // of the next entry in the directory
+  unsigned short first; // entries before this one were sent by earlier requests
+} directory_listing_type;
+
+static bool addDirectoryEntry(const char * name, uint32 size, bool directory, void * context)
+{
+  directory_listing_type * listing = (directory_listing_type *) context;
+  if(listing->index++ < listing->first)
+  {
+    return true;
+  }
+
+  unsigned short entryLength = 4 + 1 + strlen(name) + 1;
+  if(listing->length + entryLength > listing->capacity)
+  {
+    return false; // the host asks again from here
+  }
+  byte * entry = listing->body + listing->length;
+  binaryWriteLittleEndian(entry, size, 4);
+  entry[4] = directory ? 1 : 0;
+  strcpy((char *) entry + 5, name);
+  listing->length += entryLength;
+  return true;
+}
+
+BinaryProtocol::BinaryProtocol(Stream &port, Datalogger * datalogger) : port(port), datalogger(datalogger)
+{
+}
+
+int BinaryProtocol::available()
+{
+  divert();
+  return port.available();
+}
+
+int BinaryProtocol::read()
+{
+  divert();
+  return port.read();
+}
+
+int BinaryProtocol::peek()
+{
+  divert();
+  return port.peek();
+}
+
+void BinaryProtocol::flush()
+{
+  port.flush();
+}
+
+size_t BinaryProtocol::write(uint8 byte)
+{
+  return port.write(byte);
+}
+
+void BinaryProtocol::divert()
+{
+  if(receiving && millis() - lastByteAt > BINARY_FRAME_TIMEOUT_MS)
+  {
+    receiving = false;
+  }
+
+  while(port.available() > 0)
+  {
+    int value = port.peek();
+    if(!receiving && value != BINARY_SYNC)
+    {
+      return; // text for the CLI
+    }
+    port.read();
+    lastByteAt = millis();
+
+    if(value != BINARY_SYNC)
+    {
+      if(frameLength < sizeof(frame))
+      {
+        frame[frameLength++] = value;
+      }
+      else
+      {
+        overflowed = true;
+      }
+    }
+    else if(receiving && frameLength > 0)
+    {
+      receiving = false;
+      if(!overflowed)
+      {
+        handleFrame();
+      }
+    }
+    else
+    {
+      // opening zero, or another between pipelined frames
+      receiving = true;
+      frameLength = 0;
+      overflowed = false;
+    }
+  }
+}
+
+void BinaryProtocol::handleFrame()
+{
+  int length = cobsDecode(frame, frameLength);
+  if(length < BINARY_REQUEST_HEADER_LENGTH + BINARY_CRC_LENGTH)
+  {
+    return;
+  }
+  unsigned short crcAt = length - BINARY_CRC_LENGTH;
+  if(crc16(frame, crcAt) != binaryReadLittleEndian(frame + crcAt, BINARY_CRC_LENGTH))
+  {
+    LOG_DEBUG(F("binary crc"));
+    return;
+  }
+  byte operation = frame[0];
+  if(operation & (BINARY_RESPONSE | BINARY_EVENT))
+  {
+    return; // our own output looped back
+  }
+  frame[crcAt] = '\0'; // string bodies end at the crc
+
+  // not on the stack, get_values measures beneath this frame
+  static byte packet[BINARY_MAX_PACKET];
+  unsigned short bodyLength = 0;
+  packet[0] = operation | BINARY_RESPONSE;
+  packet[1] = frame[1];
+  packet[2] = dispatch(operation, (char *) frame + BINARY_REQUEST_HEADER_LENGTH, crcAt - BINARY_REQUEST_HEADER_LENGTH,
+                       packet + BINARY_RESPONSE_HEADER_LENGTH, &bodyLength);
+  if(packet[2] != binary_ok)
+  {
+    bodyLength = 0;
+  }
+  writeBinaryFrame(port, packet, BINARY_RESPONSE_HEADER_LENGTH + bodyLength);
+}
+
+
+binary_status_type BinaryProtocol::dispatch(byte operation, char * request, unsigned short requestLength, byte * body, unsigned short * length)
+{
+  switch(operation)
+  {
+  case binary_info:
+    return info(body, length);
+
+  case binary_get_config:
+    return getConfig(request, requestLength, body, length);
+
+  case binary_set_config:
+  {
+    JSONReader json(request);
+    if(!json.valid())
+    {
+      return binary_bad_request;
+    }
+    return datalogger->setConfiguration(json) ? binary_ok : binary_rejected;
+  }
+
+  case binary_set_slot_config:
+  {
+    JSONReader json(request);
+    if(!json.valid())
+    {
+      return binary_bad_request;
+    }
+    return datalogger->setSensorConfiguration(json) ? binary_ok : binary_rejected;
+  }
+
+  case binary_clear_slot:
+  {
+    byte slot = request[0];
+    if(requestLength != 1 || slot < 1 || slot > EEPROM_TOTAL_SENSOR_SLOTS)
+    {
+      return binary_bad_request;
+    }
+    return datalogger->clearSlot(slot - 1) ? binary_ok : binary_not_found;
+  }
+
+  case binary_get_values:
+    return getValues(body, length);
+
+  case binary_list_files:
+    return listFiles(request, requestLength, body, length);
+
+  case binary_read_file:
+    return readFile(request, requestLength, body, length);
+
+  case binary_start_stream:
+    return startStream(request, requestLength, body, length);
+
+  case binary_stop_stream:
+  {
+    datalogger->stopStreaming();
+    uint32 sent, dropped;
+    datalogger->getStreamCounts(&sent, &dropped);
+    binaryWriteLittleEndian(body, sent, 4);
+    binaryWriteLittleEndian(body + 4, dropped, 4);
+    *length = 8;
+    return binary_ok;
+  }
+
+  default:
+    return binary_unknown_operation;
+  }
+}
+
+binary_status_type BinaryProtocol::info(byte * body, unsigned short * length)
+{
+  body[0] = BINARY_PROTOCOL_VERSION;
+  binaryWriteLittleEndian(body + 1, BINARY_MAX_BODY, 2);
+  body[3] = datalogger->sensorCount;
+  char * strings = (char *) body + 4;
+  strcpy(strings, WATERBEAR_FIRMWARE_VERSION);
+  strings += strlen(strings) + 1;
+  strcpy(strings, datalogger->getUUIDString());
+  strings += strlen(strings) + 1;
+  *length = (byte *) strings - body;
+  return binary_ok;
+}
+
+binary_status_type BinaryProtocol::getConfig(char * request, unsigned short requestLength, byte * body, unsigned short * length)
+{
+  if(requestLength != 1)
+  {
+    return binary_bad_request;
+  }
+  byte index = request[0];
+  if(index > datalogger->sensorCount)
+  {
+    return binary_not_found;
+  }
+
+  JSONWriter json((char *) body, BINARY_MAX_BODY);
+  if(index == 0)
+  {
+    datalogger->getConfigurationJSON(json);
+  }
+  else
+  {
+    datalogger->getSensorConfiguration(index - 1, json);
+  }
+  if(!json.finish())
+  {
+    return binary_too_large;
+  }
+  *length = strlen((char *) body);
+  return binary_ok;
+}
+
+binary_status_type BinaryProtocol::getValues(byte * body, unsigned short * length)
+{
+  BodyPrint values(body, BINARY_MAX_BODY);
+  datalogger->printLiveValues(values);
+  if(values.overflowed)
+  {
+    return binary_too_large;
+  }
+  *length = values.length;
+  return binary_ok;
+}
+
+binary_status_type BinaryProtocol::listFiles(char * request, unsigned short requestLength, byte * body, unsigned short * length)
+{
+  if(requestLength < 2)
+  {
+    return binary_bad_request;
+  }
+  const char * path = request + 2;
+  if(path[0] == '\0')
+  {
+    path = BINARY_DATA_DIRECTORY;
+  }
+
+  directory_listing_type listing = { body, BINARY_MAX_BODY, 0, 0, (unsigned short) binaryReadLittleEndian(request, 2) };
+  if(!datalogger->listFiles(path, addDirectoryEntry, &listing))
+  {
+    return binary_not_found;
+  }
+  *length = listing.length;
+  return binary_ok;
+}
+
+binary_status_type BinaryProtocol::readFile(char * request, unsigned short requestLength, byte * body, unsigned short * length)
+{
+  if(requestLength < 6)
+  {
+    return binary_bad_request;
+  }
+  uint32 offset = binaryReadLittleEndian(request, 4);
+  unsigned short chunk = binaryReadLittleEndian(request + 4, 2);
+  if(chunk > BINARY_MAX_BODY - 4)
+  {
+    chunk = BINARY_MAX_BODY - 4;
+  }
+
+  int count = datalogger->readFile(request + 6, offset, body + 4, chunk);
+  if(count < 0)
+  {
+    return binary_not_found;
+  }
+  binaryWriteLittleEndian(body, offset, 4);
+  *length = 4 + count;
+  return binary_ok;
+}
+
+binary_status_type BinaryProtocol::startStream(char * request, unsigned short requestLength, byte * body, unsigned short * length)
+{
+  unsigned short slotMask = 0;
+  for(unsigned short i = 0; i < requestLength; i++)
+  {
+    byte slot = request[i];
+    if(slot < 1 || slot > EEPROM_TOTAL_SENSOR_SLOTS)
+    {
+      return binary_bad_request;
+    }
+    slotMask |= 1 << (slot - 1);
+  }
+
+  if(!datalogger->startStreaming(slotMask))
+  {
+    return binary_not_found;
+  }
+  *length = datalogger->describeStream(body, BINARY_MAX_BODY);
+  return binary_ok;
+}
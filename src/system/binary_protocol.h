@@ -0,0 +1,124 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_BINARY_PROTOCOL
+#define WATERBEAR_BINARY_PROTOCOL
+
+#include <Arduino.h>
+#include "utilities/cobs.h"
+#include "sensors/sensor.h"
+
+// Binary command protocol for tools, alongside the text CLI on the same port.
+//
+// A frame on the wire is 0x00, the COBS encoding of a packet, 0x00.  Text commands never contain a zero,
+// so the first zero switches the port to frame reception and the second hands the frame to the protocol.
+// Bytes outside frames, such as notify() output, are for the host to skip.
+//
+//   request   operation, sequence, body, crc
+//   response  operation | BINARY_RESPONSE, sequence, status, body, crc
+//   event     operation, body, crc, sent by the logger unasked, operations with BINARY_EVENT
+//
+// The crc is crc16() of the preceding bytes.  Multi byte fields are little endian, strings end with a zero
+// except a JSON or CSV body, which runs to the crc.  Frames failing the crc are dropped without a response,
+// the host resends after a timeout.  Responses carry the request's sequence and come back in order, so a
+// host can pipeline requests, keeping no more than BINARY_PIPELINE_BYTES of them unanswered.
+#define BINARY_SYNC 0x00
+#define BINARY_PROTOCOL_VERSION 1
+#define BINARY_RESPONSE 0x80
+#define BINARY_EVENT 0x40
+#define BINARY_MAX_BODY 512 // the get-config JSON of a sensor fits
+#define BINARY_REQUEST_HEADER_LENGTH 2
+#define BINARY_RESPONSE_HEADER_LENGTH 3
+#define BINARY_CRC_LENGTH 2
+#define BINARY_MAX_PACKET (BINARY_RESPONSE_HEADER_LENGTH + BINARY_MAX_BODY + BINARY_CRC_LENGTH)
+#define BINARY_PIPELINE_BYTES 64   // the USART receive buffer, filling while a response is sent
+#define BINARY_FRAME_TIMEOUT_MS 250 // a frame left open this long is abandoned and the port is back to text
+#define BINARY_DATA_DIRECTORY "/Data"
+#define BINARY_STREAM_SAMPLE_LENGTH (11 + SENSOR_MAX_RAW_VALUES * 4)
+#define BINARY_FRAME_LENGTH(packetLength) (COBS_ENCODED_LENGTH((packetLength) + BINARY_CRC_LENGTH) + 2) // on the wire
+
+typedef enum binary_operation
+{
+  binary_info = 0x01,            // -> version, max body (2), sensor count, firmware version string, uuid string
+  binary_get_config = 0x02,      // index, 0 for the datalogger or n for the nth sensor -> get-config JSON
+  binary_set_config = 0x03,      // set-config JSON
+  binary_set_slot_config = 0x04, // set-slot-config JSON
+  binary_clear_slot = 0x05,      // slot
+  binary_get_values = 0x06,      // -> CSV header and values lines, as interactive logging prints them
+  binary_list_files = 0x07,      // first entry (2), path, BINARY_DATA_DIRECTORY if empty -> entries of size (4), directory flag, name
+  binary_read_file = 0x08,       // offset (4), length (2), path -> offset (4), data, empty at the end of the file
+  binary_start_stream = 0x09,    // slots, every configured slot if empty -> per slot: slot, column headers string
+  binary_stop_stream = 0x0A,     // -> samples sent (4), samples dropped (4)
+
+  binary_stream_sample = BINARY_EVENT | 0x01 // sequence (4), millis() captured (4), slot, count, count float values
+} binary_operation_type;
+
+typedef enum binary_status
+{
+  binary_ok = 0,
+  binary_bad_request = 1,        // the body is malformed
+  binary_unknown_operation = 2,
+  binary_rejected = 3,           // the datalogger refused the change, notify() says why
+  binary_not_found = 4,          // no such sensor, slot, file or directory
+  binary_too_large = 5           // the response would exceed BINARY_MAX_BODY
+} binary_status_type;
+
+class Datalogger;
+
+uint32 binaryReadLittleEndian(const void * data, byte count);
+void binaryWriteLittleEndian(byte * data, uint32 value, byte count);
+
+// packet is a response or event with room for the crc after it
+void writeBinaryFrame(Print &output, byte * packet, unsigned short length);
+
+// Sits between the command port and the Cmd text CLI.  Text passes through unchanged,
+// frames are taken out of the input as the CLI polls and answered on the same port.
+class BinaryProtocol : public Stream
+{
+public:
+  BinaryProtocol(Stream &port, Datalogger * datalogger);
+
+  int available();
+  int read();
+  int peek();
+  void flush();
+  size_t write(uint8 byte);
+  using Print::write;
+
+private:
+  Stream &port;
+  Datalogger * datalogger;
+  byte frame[COBS_ENCODED_LENGTH(BINARY_MAX_PACKET)];
+  unsigned short frameLength = 0;
+  bool receiving = false;
+  bool overflowed = false;
+  uint32 lastByteAt = 0;
+
+  void divert();
+  void handleFrame();
+  binary_status_type dispatch(byte operation, char * request, unsigned short requestLength, byte * body, unsigned short * length);
+
+  binary_status_type info(byte * body, unsigned short * length);
+  binary_status_type getConfig(char * request, unsigned short requestLength, byte * body, unsigned short * length);
+  binary_status_type getValues(byte * body, unsigned short * length);
+  binary_status_type listFiles(char * request, unsigned short requestLength, byte * body, unsigned short * length);
+  binary_status_type readFile(char * request, unsigned short requestLength, byte * body, unsigned short * length);
+  binary_status_type startStream(char * request, unsigned short requestLength, byte * body, unsigned short * length);
+};
+
+#endif
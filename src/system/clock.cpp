@@ -19,6 +19,7 @@
 #include "clock.h"
 #include "configuration.h"
 #include <RTClock.h>
+#include <libmaple/systick.h>
 #include "filesystem.h"
 #include "logs.h"
 
@@ -30,14 +31,160 @@ void handleInterrupt(){
   // Serial2.println("RTC interrupt!!");
 }
 
+// The internal RTC counter runs freely from LSE and is never reset, alarms are set relative to it
+// so time spent between reading the clock and sleeping doesn't accumulate as drift
+RTClock * internalRTC = NULL;
+
+// Software clock, epoch time derived from the internal RTC counter and disciplined by the DS3231
+// The DS3231 is read when syncing and once per wake, not on every timestamp() call
+bool clockSynced = false;
+time_t anchorEpoch = 0;   // epoch second that started at anchorTicks
+uint32 anchorTicks = 0;
+time_t lastSyncEpoch = 0; // DS3231 time and counter at the last sync, for measuring drift
+uint32 lastSyncTicks = 0;
+uint32 lastAlarmTicks = 0; // last internal RTC alarm
+unsigned long ticksPerKilosecond = (unsigned long) INTERNAL_RTC_TICKS_PER_SECOND * 1000; // measured LSE rate
+
+void startInternalRTC()
+{
+  if (internalRTC == NULL)
+  {
+    internalRTC = new RTClock(RTCSEL_LSE, INTERNAL_RTC_PRESCALER);
+  }
+}
+
+uint32 internalRTCTicks()
+{
+  return rtc_get_count();
+}
+
+void syncClock()
+{
+  // line the counter up with the start of a DS3231 second
+  short second = Clock.getSecond();
+  uint32 started = millis();
+  while (Clock.getSecond() == second && millis() - started < 1100)
+  {
+  }
+  uint32 ticks = internalRTCTicks();
+  time_t epoch = readDS3231Timestamp();
+
+  if (clockSynced && epoch - lastSyncEpoch >= CLOCK_MINIMUM_DRIFT_MEASUREMENT_SECONDS && epoch - lastSyncEpoch < CLOCK_MAXIMUM_DRIFT_MEASUREMENT_SECONDS)
+  {
+    // measure the LSE rate against the DS3231 since the last sync
+    unsigned long long measured = (unsigned long long) (ticks - lastSyncTicks) * 1000 / (epoch - lastSyncEpoch);
+    unsigned long nominal = (unsigned long) INTERNAL_RTC_TICKS_PER_SECOND * 1000;
+    if (measured > nominal - CLOCK_MAXIMUM_DRIFT_TICKS && measured < nominal + CLOCK_MAXIMUM_DRIFT_TICKS)
+    {
+      ticksPerKilosecond = (unsigned long) measured;
+    }
+    char message[50];
+    sprintf(message, "clock ticks/ks: %lu", ticksPerKilosecond);
+    debug(message);
+  }
+
+  anchorTicks = lastSyncTicks = ticks;
+  anchorEpoch = lastSyncEpoch = epoch;
+  clockSynced = true;
+}
+
+void checkClock()
+{
+  // one DS3231 read, full resync when it disagrees or the resync interval has passed
+  time_t ds3231Epoch = readDS3231Timestamp();
+  long difference = (long) (ds3231Epoch - timestamp());
+  if (!clockSynced || difference > 1 || difference < -1 || ds3231Epoch - lastSyncEpoch >= CLOCK_RESYNC_INTERVAL_SECONDS)
+  {
+    syncClock();
+  }
+}
+
+void clockTime(time_t * epoch, unsigned short * milliseconds)
+{
+  if (!clockSynced)
+  {
+    *epoch = readDS3231Timestamp();
+    *milliseconds = 0;
+    return;
+  }
+
+  uint32 elapsed = internalRTCTicks() - anchorTicks;
+  if (elapsed >= ticksPerKilosecond)
+  {
+    // move the anchor forward in whole kiloseconds, exact at the measured rate, so the counter can wrap (every 48 days)
+    uint32 kiloseconds = elapsed / ticksPerKilosecond;
+    anchorTicks += kiloseconds * ticksPerKilosecond;
+    anchorEpoch += kiloseconds * 1000;
+  }
+  clockTimeForTicks(internalRTCTicks(), epoch, milliseconds);
+}
+
+void clockTimeForTicks(uint32 ticks, time_t * epoch, unsigned short * milliseconds)
+{
+  // ticks may be from just before the anchor moved, so the difference is signed
+  long long elapsedMillis = (long long) (long) (ticks - anchorTicks) * 1000000 / (long long) ticksPerKilosecond;
+  long long seconds = elapsedMillis / 1000;
+  long long remainder = elapsedMillis % 1000;
+  if (remainder < 0)
+  {
+    seconds -= 1;
+    remainder += 1000;
+  }
+  *epoch = anchorEpoch + (time_t) seconds;
+  *milliseconds = (unsigned short) remainder;
+}
+
+void addSleepToMillis(uint32 sleepStartTicks)
+{
+  // SysTick is stopped in sleep and stop mode, credit millis() with the time measured by the RTC
+  uint32 sleptTicks = internalRTCTicks() - sleepStartTicks;
+  systick_uptime_millis += (uint32) ((unsigned long long) sleptTicks * 125 / 128);
+}
+
+uint32 internalRTCTicksForEpoch(time_t epoch)
+{
+  time_t now;
+  unsigned short milliseconds;
+  clockTime(&now, &milliseconds); // moves the anchor forward
+  long long elapsedSeconds = (long long) epoch - (long long) anchorEpoch;
+  if (elapsedSeconds < 0)
+  {
+    // deadline before the anchor, the caller treats the anchor as already passed
+    elapsedSeconds = 0;
+  }
+  return anchorTicks + (uint32) ((unsigned long long) elapsedSeconds * ticksPerKilosecond / 1000);
+}
+
+uint32 internalRTCAlarmTicks()
+{
+  return lastAlarmTicks;
+}
+
+void setInternalRTCAlarm(uint32 ticks)
+{
+  lastAlarmTicks = ticks;
+  internalRTC->removeAlarm();
+  internalRTC->createAlarm(handleInterrupt, ticks);
+}
+
+void setNextAlarmInternalRTCEpoch(time_t epoch)
+{
+  uint32 alarmTicks = internalRTCTicksForEpoch(epoch);
+  if ((long) (alarmTicks - internalRTCTicks()) < INTERNAL_RTC_MINIMUM_ALARM_TICKS)
+  {
+    // deadline already passed or too close to reach stop mode before it fires
+    alarmTicks = internalRTCTicks() + INTERNAL_RTC_MINIMUM_ALARM_TICKS;
+  }
+  setInternalRTCAlarm(alarmTicks);
+
+  char message[50];
+  sprintf(message, "set alarm for epoch: %lu", (unsigned long) epoch);
+  debug(message);
+}
+
 void setNextAlarmInternalRTC(short interval){
   short minutes = Clock.getMinute();
-  //Serial2.println("minutes");
-  //Serial2.println(Clock.getMinute(), DEC);
-  //Serial2.println(minutes);
   short seconds = Clock.getSecond();
-  // Serial2.println("seconds");
-  // Serial2.println(seconds);
   // an example of the math
   // time = 10:48:12 (current time)
   // minutes = 48 ( current minutes)
@@ -47,88 +194,28 @@ void setNextAlarmInternalRTC(short interval){
   // minutesDiff = 60 - 48 = 12
   // minutesDiffSeconds = 12 * 60 = 720
   // secondsUntilWake = 720 - 12 = 708
-  // Serial2.println("interval");
-  // Serial2.println(interval);
-  // Serial2.println("minutes");
-  // Serial2.println(minutes);
   short nextMinutes = (minutes + interval - (minutes % interval));
-  Serial2.println("next minutes");
-  Serial2.println(nextMinutes);
   short minutesDiff = nextMinutes - minutes;
   short minutesDiffSeconds = minutesDiff * 60;
   short secondsUntilWake = minutesDiffSeconds - seconds; // -offset.  Offset would allow for some startup time.
-  // Serial2.println("seconds until wake");
-  // Serial2.println(secondsUntilWake);
 
-  RTClock * clock = new RTClock(RTCSEL_LSE);
-  Serial2.println("made clock");  Serial2.flush();
+  setNextAlarmInternalRTCSeconds(secondsUntilWake);
 
   char message[100];
-  sprintf(message, "Got clock value (current): %lli", clock->getTime());
-  debug(message);
-    
-  clock->setTime(0);
-  sprintf(message, "Got clock value (reset): %lli", clock->getTime());
-  debug(message);
-
-  clock->removeAlarm();
-  // secondsUntilWake = 10;
-  clock->setAlarmTime(secondsUntilWake);
-  clock->createAlarm(handleInterrupt, secondsUntilWake);
-  delete clock;
-
   sprintf(message, "set alarm time to wake: %i", secondsUntilWake);
   debug(message);
-
 }
 
 
-void setNextAlarmInternalRTCSeconds(short seconds)
+void setNextAlarmInternalRTCSeconds(uint32 seconds)
 {
-
-  RTClock * clock = new RTClock(RTCSEL_LSE);
-  // Serial2.println("made clock");  Serial2.flush();
-
-  // char message[100];
-  // sprintf(message, "Got clock value (current): %lli", clock->getTime());
-  // debug(message);
-  
-  clock->setTime(0);
-  // sprintf(message, "Got clock value (reset): %lli", clock->getTime());
-  // debug(message);
-
-  clock->removeAlarm();
-  clock->setAlarmTime(seconds);
-  clock->createAlarm(handleInterrupt, seconds);
-  delete clock;
-
-  // sprintf(message, "set alarm seconds until wake: %i", seconds);
-  // notify(message);
-
+  setInternalRTCAlarm(internalRTCTicks() + seconds * INTERNAL_RTC_TICKS_PER_SECOND);
 }
 
 void setNextAlarmInternalRTCMilliseconds(int milliseconds)
 {
-
-  RTClock * clock = new RTClock(RTCSEL_LSE, 32); //according to sheet clock/(prescaler + 1) = Hz
-  // Serial2.println("made clock");  Serial2.flush();
-
-  // char message[100];
-  // sprintf(message, "Got clock value (current): %lli", clock->getTime());
-  // debug(message);
-    
-  clock->setTime(0);
-  // sprintf(message, "Got clock value (reset): %lli", clock->getTime());
-  // debug(message);
-
-  clock->removeAlarm();
-  clock->setAlarmTime(milliseconds);
-  clock->createAlarm(handleInterrupt, milliseconds);
-  delete clock;
-
-  // sprintf(message, "set alarm milliseconds until wake: %i", milliseconds);
-  // notify(message);
-
+  // 1024 ticks per second, 128 / 125 ticks per millisecond
+  setInternalRTCAlarm(internalRTCTicks() + ((uint32) milliseconds * 128) / 125);
 }
 
 #ifdef USES_DS3231_ALARM
@@ -183,15 +270,14 @@ void setNextAlarm(short interval)
 
 void dateTime(uint16_t* date, uint16_t* time)
 {
-  // Fetch time from DS3231 RTC
-  bool century = false;
-	bool h24Flag;
-	bool pmFlag;
+  // SdFat callback, from the software clock
+  time_t now = timestamp();
+  struct tm ts = *gmtime(&now);
   // return date using FAT_DATE macro to format fields
-  *date = FAT_DATE(Clock.getYear() + 1900, Clock.getMonth(century) + 1, Clock.getDate()); // year is since 1900, months range 0-11
+  *date = FAT_DATE(ts.tm_year + 1900, ts.tm_mon + 1, ts.tm_mday); // year is since 1900, months range 0-11
 
   // return time using FAT_TIME macro to format fields
-  *time = FAT_TIME(Clock.getHour(h24Flag, pmFlag), Clock.getMinute(), Clock.getSecond());
+  *time = FAT_TIME(ts.tm_hour, ts.tm_min, ts.tm_sec);
 }
 
 void clearAllAlarms()
@@ -204,6 +290,14 @@ void clearAllAlarms()
 
 
 time_t timestamp()
+{
+  time_t epoch;
+  unsigned short milliseconds;
+  clockTime(&epoch, &milliseconds);
+  return epoch;
+}
+
+time_t readDS3231Timestamp()
 {
   struct tm ts;
   bool century = false;
@@ -236,6 +330,12 @@ void setTime(time_t toSet)
   Clock.setHour(ts.tm_hour);
   Clock.setMinute(ts.tm_min);
   Clock.setSecond(ts.tm_sec);
+
+  if (internalRTC != NULL)
+  {
+    clockSynced = false; // a step, not drift
+    syncClock();
+  }
 }
 
 void t_t2ts(time_t epochTS, uint32 currentMillis, char *humanTime)
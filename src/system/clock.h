@@ -36,8 +36,31 @@ extern DS3231 Clock;
 //byte ALRM2_SET = ALRM2_ONCE_PER_MIN;
 
 
+#define INTERNAL_RTC_PRESCALER 31 // LSE 32768 Hz / (31 + 1)
+#define INTERNAL_RTC_TICKS_PER_SECOND 1024
+#define INTERNAL_RTC_MINIMUM_ALARM_TICKS 1024 // time to power down and enter stop mode before the alarm
+
+#define CLOCK_RESYNC_INTERVAL_SECONDS 86400
+#define CLOCK_MINIMUM_DRIFT_MEASUREMENT_SECONDS 3600 // shorter spans are dominated by the edge detection error
+#define CLOCK_MAXIMUM_DRIFT_MEASUREMENT_SECONDS 3456000 // 40 days, before the counter wraps
+#define CLOCK_MAXIMUM_DRIFT_TICKS 512 // per kilosecond, 500ppm, larger measurements are discarded
+
+void startInternalRTC();
+uint32 internalRTCTicks();
+uint32 internalRTCTicksForEpoch(time_t epoch);
+uint32 internalRTCAlarmTicks(); // counter value the last alarm was set for
+void setInternalRTCAlarm(uint32 ticks);
+
+// software clock
+void syncClock();  // align with a DS3231 second edge, takes up to a second
+void checkClock(); // single DS3231 read, syncs when needed
+void clockTime(time_t * epoch, unsigned short * milliseconds);
+void clockTimeForTicks(uint32 ticks, time_t * epoch, unsigned short * milliseconds);
+void addSleepToMillis(uint32 sleepStartTicks); // after waking, SysTick doesn't count while asleep
+
+void setNextAlarmInternalRTCEpoch(time_t epoch);
 void setNextAlarmInternalRTC(short interval);
-void setNextAlarmInternalRTCSeconds(short seconds);
+void setNextAlarmInternalRTCSeconds(uint32 seconds);
 void setNextAlarmInternalRTCMilliseconds(int milliseconds);
 
 #ifdef USES_DS3231_ALARM
@@ -46,7 +69,8 @@ void setNextAlarm(short interval);
 
 void dateTime(uint16_t* date, uint16_t* time);
 void clearAllAlarms();
-time_t timestamp();
+time_t timestamp(); // from the software clock
+time_t readDS3231Timestamp();
 void setTime(time_t toSet);
 void t_t2ts(time_t epochTS, uint32 currentMillis, char *humanTime);
 
@@ -24,6 +24,8 @@
 #include "utilities/qos.h"
 #include "scratch/dbgmcu.h"
 #include "system/logs.h"
+#include "system/trace.h"
+#include "system/memory.h"
 
 #define MAX_REQUEST_LENGTH 70 // serial commands
 
@@ -48,9 +50,9 @@ const __FlashStringHelper * conditions = F("conditions...");
 // along with this program.  If not, see <http://www.gnu.org/licenses/>
 // )RRIV");
 
-CommandInterface * CommandInterface::create(HardwareSerial &port, Datalogger * datalogger)
+CommandInterface * CommandInterface::create(Stream &port, Datalogger * datalogger)
 {
-  commandInterface = new CommandInterface(Serial2, datalogger);
+  commandInterface = new CommandInterface(port, datalogger);
   return commandInterface;
 }
 
@@ -60,10 +62,10 @@ CommandInterface * CommandInterface::instance()
   return commandInterface;
 }
 
-CommandInterface::CommandInterface(HardwareSerial &port, Datalogger * datalogger)
+CommandInterface::CommandInterface(Stream &port, Datalogger * datalogger) : binaryProtocol(port, datalogger)
 {
   this->datalogger = datalogger;
-  cmdInit(&port);
+  cmdInit(&binaryProtocol);
 }
 
 
@@ -126,6 +128,12 @@ void toggleTrace(int arg_cnt, char **args)
   Monitor::instance()->debugToSerial = !Monitor::instance()->debugToSerial;
 }
 
+void toggleBinaryTrace(int arg_cnt, char **args)
+{
+  // binary records need tools/log_decoder.py on the host to read them
+  Monitor::instance()->binaryRecords = !Monitor::instance()->binaryRecords;
+}
+
 void startLogging(int arg_cnt, char **args)
 {
   CommandInterface::instance()->_startLogging();
@@ -150,6 +158,17 @@ void CommandInterface::_stopLogging()
   ok();
 }
 
+void stopStreaming(int arg_cnt, char **args)
+{
+  CommandInterface::instance()->_stopStreaming();
+}
+
+void CommandInterface::_stopStreaming()
+{
+  this->datalogger->stopStreaming();
+  ok();
+}
+
 void testMeasurementCycle(int arg_cnt, char **args)
 {
   CommandInterface::instance()->_testMeasurementCycle();
@@ -342,6 +361,45 @@ void CommandInterface::_setBurstDelay(int number)
   notify(F("OK"));
 }
 
+void calibrateBattery(int arg_cnt, char **args)
+{
+  if(arg_cnt < 2){
+    invalidArgumentsMessage(F("calibrate-battery MEASURED_BATTERY_MILLIVOLTS"));
+    return;
+  }
+
+  // use singleton to get back into OOP context
+  int millivolts = atoi(args[1]);
+  CommandInterface::instance()->_calibrateBattery(millivolts);
+}
+
+void CommandInterface::_calibrateBattery(int millivolts)
+{
+  this->datalogger->calibrateBattery(millivolts);
+  ok();
+}
+
+void setBatteryTiers(int arg_cnt, char **args)
+{
+  if(arg_cnt < BATTERY_TIER_COUNT + 1){
+    invalidArgumentsMessage(F("set-battery-tiers TIER1_MILLIVOLTS TIER2_MILLIVOLTS TIER3_MILLIVOLTS TIER4_MILLIVOLTS"));
+    return;
+  }
+
+  unsigned short tierMillivolts[BATTERY_TIER_COUNT];
+  for(unsigned short i = 0; i < BATTERY_TIER_COUNT; i++)
+  {
+    tierMillivolts[i] = atoi(args[i + 1]);
+  }
+  CommandInterface::instance()->_setBatteryTiers(tierMillivolts);
+}
+
+void CommandInterface::_setBatteryTiers(unsigned short * tierMillivolts)
+{
+  this->datalogger->setBatteryTiers(tierMillivolts);
+  ok();
+}
+
 
 void printWarranty(int arg_cnt, char **args)
 {
@@ -367,48 +425,32 @@ void getConfig(int arg_cnt, char **args)
   // notify(freeMemory());
 }
 
-#define BUFFER_SIZE 400
+#define BUFFER_SIZE 500
 void CommandInterface::_getConfig()
 {
-  datalogger_settings_type dataloggerSettings = this->datalogger->settings;
-  this->datalogger->getConfiguration(&dataloggerSettings);
- 
-  cJSON* dataloggerConfiguration = cJSON_CreateObject();
-  cJSON_AddStringToObject(dataloggerConfiguration, reinterpretCharPtr(F("device_uuid")), this->datalogger->getUUIDString());
-  // cJSON_AddStringToObject(json, reinterpretCharPtr(F("device_name")), dataloggerSettings.deviceName);
-  cJSON_AddStringToObject(dataloggerConfiguration, reinterpretCharPtr(F("site_name")), dataloggerSettings.siteName);
-  cJSON_AddStringToObject(dataloggerConfiguration, reinterpretCharPtr(F("logger_name")), dataloggerSettings.loggerName);
-  cJSON_AddStringToObject(dataloggerConfiguration, reinterpretCharPtr(F("deployment_identifier")), dataloggerSettings.deploymentIdentifier);
-  cJSON_AddNumberToObject(dataloggerConfiguration, reinterpretCharPtr(F("interval(min)")), dataloggerSettings.interval);
-  cJSON_AddNumberToObject(dataloggerConfiguration, reinterpretCharPtr(F("burst_number")), dataloggerSettings.burstNumber);
-  cJSON_AddNumberToObject(dataloggerConfiguration, reinterpretCharPtr(F("start_up_delay(min)")), dataloggerSettings.startUpDelay);
-  cJSON_AddNumberToObject(dataloggerConfiguration, reinterpretCharPtr(F("burst_delay(min)")), dataloggerSettings.interBurstDelay);
-
   char string[BUFFER_SIZE];
-  cJSON_PrintPreallocated(dataloggerConfiguration, string, BUFFER_SIZE, true);
-  if (string == NULL)
+  JSONWriter dataloggerConfiguration(string, BUFFER_SIZE);
+  this->datalogger->getConfigurationJSON(dataloggerConfiguration);
+
+  if (!dataloggerConfiguration.finish())
   {
-    fprintf(stderr, reinterpretCharPtr(F("Failed to print json.\n")));
+    notify(F("Failed to print json"));
     return;
   }
   notify(string);
-  
-  cJSON_Delete(dataloggerConfiguration);
 
   debug("sensorCount is:");
   debug(short(this->datalogger->sensorCount));
   for(unsigned short i=0; i<this->datalogger->sensorCount; i++)
   {
-    cJSON * sensorConfiguration= this->datalogger->getSensorConfiguration(i);
-    cJSON_PrintPreallocated(sensorConfiguration, string, BUFFER_SIZE, true);
-    if (string == NULL)
+    JSONWriter sensorConfiguration(string, BUFFER_SIZE);
+    this->datalogger->getSensorConfiguration(i, sensorConfiguration);
+    if (!sensorConfiguration.finish())
     {
-      fprintf(stderr, reinterpretCharPtr(F("Failed to print json.\n")));
+      notify(F("Failed to print json"));
       return;
     }
     notify(string);
-
-    cJSON_Delete(sensorConfiguration);
   }
 }
 
@@ -425,19 +467,15 @@ void setConfig(int arg_cnt, char **args)
 
 void CommandInterface::_setConfig(char * config)
 {
-  cJSON *json = cJSON_Parse(config);
-  if(json == NULL){
+  JSONReader json(config);
+  if(!json.valid()){
     notify(F("Invalid JSON"));
     return;
   }
 
-  char * printString = cJSON_Print(json);
-  notify(printString);
-  delete(printString);
+  notify(config);
 
   this->datalogger->setConfiguration(json);
-
-  cJSON_Delete(json);
 }
 
 void setSlotConfig(int arg_cnt, char **args)
@@ -456,48 +494,15 @@ void CommandInterface::_setSlotConfig(char * config)
 {
   // debug(F("set slot config check JSON"));
 
-  cJSON *json = cJSON_Parse(config);
-  if(json == NULL){
+  JSONReader json(config);
+  if(!json.valid()){
     notify(F("Invalid JSON"));
     return;
   }
 
-  const char * printString = cJSON_Print(json);
-  notify(printString);
-  delete(printString);
-
-  const cJSON* slotJSON = cJSON_GetObjectItemCaseSensitive(json, "slot");
-  const cJSON* typeJSON = cJSON_GetObjectItemCaseSensitive(json, "type");
-
-  char type[30];
-
-  if(slotJSON != NULL && cJSON_IsNumber(slotJSON)){
-    short slot = slotJSON->valueint;
-    if(slot >= EEPROM_TOTAL_SENSOR_SLOTS || slot == 0)
-    {
-      notify(F("Invalid slot"));
-      return;
-    }
-  }
-  else
-  {
-    notify(F("Invalid slot"));
-    return;
-  }
-
-  if (cJSON_IsString(typeJSON) && (typeJSON->valuestring != NULL))
-  {
-    strcpy(type, typeJSON->valuestring);
-  }
-  else
-  {
-    notify(F("Invalid type"));
-    return;
-  }
-
-  this->datalogger->setSensorConfiguration(type, json);
+  notify(config);
 
-  cJSON_Delete(json);
+  this->datalogger->setSensorConfiguration(json);
 }
 
 void clearSlot(int arg_cnt, char **args)
@@ -548,7 +553,7 @@ void getRTC(int arg_cnt, char **args)
 
 void restart(int arg_cnt, char **args)
 {
-  nvic_sys_reset();
+  resetWithReason(trace_reset_command);
 }
 
 void deployNow(int arg_cnt, char **args)
@@ -633,6 +638,11 @@ void checkMemory(int arg_cnt, char **args)
   printFreeMemory();
 }
 
+void printMemory(int arg_cnt, char **args)
+{
+  printMemoryStatistics();
+}
+
 void doScanIC2(int arg_cnt, char**args)
 {
   // scanIC2(&Wire);
@@ -695,15 +705,20 @@ void CommandInterface::_help()
   "set-burst-number\n"
   "set-start-up-delay\n"
   "set-burst-delay\n"
+  "calibrate-battery\n"
+  "set-battery-tiers\n"
   "calibrate\n"
   "set-user-note\n"
   "set-user-value\n"
   "start-logging\n"
   "stop-logging\n"
+  "stop-streaming\n"
   "deploy-now\n"
   "interactive or i\n"
   "trace\n"
+  "trace-binary\n"
   "check-memory\n"
+  "memory\n"
   "scan-ic2\n"
   "go\n"
   "reload-sensors\n"
@@ -759,6 +774,8 @@ void CommandInterface::setup(){
   cmdAdd("set-burst-number", setBurstNumber);
   cmdAdd("set-start-up-delay", setStartUpDelay);
   cmdAdd("set-burst-delay", setBurstDelay);
+  cmdAdd("calibrate-battery", calibrateBattery);
+  cmdAdd("set-battery-tiers", setBatteryTiers);
 
   cmdAdd("calibrate", calibrate);
   
@@ -766,8 +783,10 @@ void CommandInterface::setup(){
   cmdAdd("set-user-value", setUserValue);
 
   cmdAdd("trace", toggleTrace);
+  cmdAdd("trace-binary", toggleBinaryTrace);
   cmdAdd("start-logging", startLogging);
   cmdAdd("stop-logging", stopLogging);
+  cmdAdd("stop-streaming", stopStreaming);
   cmdAdd("measurement-cycle", testMeasurementCycle);
 
   cmdAdd("deploy-now", deployNow);
@@ -777,6 +796,7 @@ void CommandInterface::setup(){
   // qos commands / debug commands
   cmdAdd("restart", restart);
   cmdAdd("check-memory", checkMemory);
+  cmdAdd("memory", printMemory);
   cmdAdd("scan-ic2", doScanIC2);
   cmdAdd("go", go);
   cmdAdd("reload-sensors", reloadSensorConfigurations);
@@ -25,6 +25,7 @@
 #include "DS3231.h"
 #include "time.h"
 #include "datalogger.h"
+#include "system/binary_protocol.h"
 
 
 // Forward declaration of class
@@ -65,12 +66,12 @@ class CommandInterface
   public:
 
     // TODO: rewrite CommandInterface as OOP class
-    static CommandInterface * create(HardwareSerial &port, Datalogger * datalogger);
+    static CommandInterface * create(Stream &port, Datalogger * datalogger);
     static CommandInterface * instance();
 
     int state;
 
-    CommandInterface(HardwareSerial &port, Datalogger * datalogger);
+    CommandInterface(Stream &port, Datalogger * datalogger);
 
     void setup();
     void poll();
@@ -102,6 +103,8 @@ class CommandInterface
     void _setBurstNumber(int number);
     void _setStartUpDelay(int number);
     void _setBurstDelay(int number);
+    void _calibrateBattery(int millivolts);
+    void _setBatteryTiers(unsigned short * tierMillivolts);
     
     void _setUserNote(char * note);
     void _setUserValue(int value);
@@ -119,6 +122,7 @@ class CommandInterface
     void _toggleDebug();
     void _startLogging();
     void _stopLogging();
+    void _stopStreaming();
     void _testMeasurementCycle();
     void _go();
     void _reloadSensorConfigurations();
@@ -133,6 +137,7 @@ class CommandInterface
 
   private:
     Datalogger * datalogger;
+    BinaryProtocol binaryProtocol; // the port as the CLI sees it, with binary frames taken out
     void * lastCommandPayload;
     bool lastCommandPayloadAllocated = false;
 };
@@ -0,0 +1,133 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "configuration_cache.h"
+#include <stddef.h>
+#include <libmaple/flash.h>
+#include "configuration_store.h"
+#include "utilities/crc.h"
+#include "system/logs.h"
+
+#define FLASH_UNLOCK_KEY1 0x45670123
+#define FLASH_UNLOCK_KEY2 0xCDEF89AB
+
+const configuration_cache_type * configurationCache()
+{
+  return (const configuration_cache_type *) CONFIGURATION_CACHE_ADDRESS;
+}
+
+unsigned short configurationCacheCRC(const configuration_cache_type * cache)
+{
+  return crc16(cache->uuid, sizeof(configuration_cache_type) - offsetof(configuration_cache_type, uuid));
+}
+
+bool configurationCacheIsValid()
+{
+  const configuration_cache_type * cache = configurationCache();
+  if(cache->version != CONFIGURATION_CACHE_VERSION || cache->crc != configurationCacheCRC(cache))
+  {
+    debug(F("Config cache missing"));
+    return false;
+  }
+
+  // any settings or slot change rewrites the settings trailer, so this one read detects a stale cache
+  configuration_store_trailer eepromTrailer;
+  readObjectFromEEPROM(EEPROM_DATALOGGER_CONFIGURATION_START + CONFIGURATION_STORE_PAYLOAD_SIZE, &eepromTrailer, sizeof(eepromTrailer));
+  if(memcmp(&eepromTrailer, &cache->dataloggerConfiguration[CONFIGURATION_STORE_PAYLOAD_SIZE], sizeof(eepromTrailer)) != 0)
+  {
+    debug(F("Config cache stale"));
+    return false;
+  }
+  return true;
+}
+
+void waitForFlash()
+{
+  while(FLASH_BASE->SR & FLASH_SR_BSY);
+}
+
+void unlockFlash()
+{
+  if(FLASH_BASE->CR & FLASH_CR_LOCK)
+  {
+    FLASH_BASE->KEYR = FLASH_UNLOCK_KEY1;
+    FLASH_BASE->KEYR = FLASH_UNLOCK_KEY2;
+  }
+}
+
+void lockFlash()
+{
+  FLASH_BASE->CR |= FLASH_CR_LOCK;
+}
+
+void eraseFlashPage(uint32 address)
+{
+  waitForFlash();
+  FLASH_BASE->CR |= FLASH_CR_PER;
+  FLASH_BASE->AR = address;
+  FLASH_BASE->CR |= FLASH_CR_STRT;
+  waitForFlash();
+  FLASH_BASE->CR &= ~FLASH_CR_PER;
+}
+
+void programFlash(uint32 address, const void * data, unsigned int length) // length must be even
+{
+  const uint16 * halfWords = (const uint16 *) data;
+  FLASH_BASE->CR |= FLASH_CR_PG;
+  for(unsigned int i = 0; i < length / 2; i++)
+  {
+    *(volatile uint16 *)(address + 2 * i) = halfWords[i];
+    waitForFlash();
+  }
+  FLASH_BASE->CR &= ~FLASH_CR_PG;
+}
+
+void rebuildConfigurationCache()
+{
+  notify(F("Rebuild config cache"));
+
+  const configuration_cache_type * cache = configurationCache();
+  uint32 base = CONFIGURATION_CACHE_ADDRESS;
+  byte block[EEPROM_DATALOGGER_SENSOR_SIZE];
+  unsigned short crc = CRC16_INITIAL_VALUE;
+
+  unlockFlash();
+  eraseFlashPage(CONFIGURATION_CACHE_ADDRESS);
+
+  // copy one region at a time so no full image is held in RAM
+  readObjectFromEEPROM(EEPROM_UUID_ADDRESS_START, block, CONFIGURATION_CACHE_UUID_SIZE);
+  programFlash(base + offsetof(configuration_cache_type, uuid), block, CONFIGURATION_CACHE_UUID_SIZE);
+  crc = crc16(block, CONFIGURATION_CACHE_UUID_SIZE, crc);
+
+  readObjectFromEEPROM(EEPROM_DATALOGGER_CONFIGURATION_START, block, EEPROM_DATALOGGER_CONFIGURATION_SIZE);
+  programFlash(base + offsetof(configuration_cache_type, dataloggerConfiguration), block, EEPROM_DATALOGGER_CONFIGURATION_SIZE);
+  crc = crc16(block, EEPROM_DATALOGGER_CONFIGURATION_SIZE, crc);
+
+  for(short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    readSensorConfigurationFromEEPROM(slot, block);
+    programFlash((uint32) cache->sensorConfigurations[slot], block, EEPROM_DATALOGGER_SENSOR_SIZE);
+    crc = crc16(block, EEPROM_DATALOGGER_SENSOR_SIZE, crc);
+  }
+
+  programFlash(base + offsetof(configuration_cache_type, crc), &crc, sizeof(crc));
+  unsigned short version = CONFIGURATION_CACHE_VERSION;
+  programFlash(base + offsetof(configuration_cache_type, version), &version, sizeof(version));
+
+  lockFlash();
+}
@@ -0,0 +1,52 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_CONFIGURATION_CACHE
+#define WATERBEAR_CONFIGURATION_CACHE
+
+#include <Arduino.h>
+#include "eeprom.h"
+
+// last 1KB page of the F103RB's 128KB flash, kept out of the firmware image by board_upload.maximum_size
+#define CONFIGURATION_CACHE_ADDRESS 0x0801FC00
+#define CONFIGURATION_CACHE_PAGE_SIZE 1024
+
+// layout changes with the slot count, so include it in the version
+#define CONFIGURATION_CACHE_VERSION (0x0100 | EEPROM_TOTAL_SENSOR_SLOTS)
+
+#define CONFIGURATION_CACHE_UUID_SIZE (EEPROM_UUID_ADDRESS_END - EEPROM_UUID_ADDRESS_START + 1)
+
+// copy of the external EEPROM configuration regions
+typedef struct
+{
+  unsigned short version; // 2 bytes, written last so an interrupted rebuild reads as missing
+  unsigned short crc;     // 2 bytes, over everything below
+  byte uuid[CONFIGURATION_CACHE_UUID_SIZE];
+  byte dataloggerConfiguration[EEPROM_DATALOGGER_CONFIGURATION_SIZE];
+  byte sensorConfigurations[EEPROM_TOTAL_SENSOR_SLOTS][EEPROM_DATALOGGER_SENSOR_SIZE];
+} configuration_cache_type;
+
+const configuration_cache_type * configurationCache(); // memory mapped, read directly from flash
+
+// valid when the image crc matches and the EEPROM settings trailer matches the cached copy
+bool configurationCacheIsValid();
+
+// copy the configuration regions from the external EEPROM into flash
+void rebuildConfigurationCache();
+
+#endif
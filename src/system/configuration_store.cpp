@@ -0,0 +1,125 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "configuration_store.h"
+#include "utilities/crc.h"
+#include "system/logs.h"
+
+ConfigurationStore::ConfigurationStore(int i2cAddress, short baseAddress)
+{
+  this->i2cAddress = i2cAddress;
+  this->baseAddress = baseAddress;
+  memset(mirror, EEPROM_RESET_VALUE, CONFIGURATION_STORE_BLOCK_SIZE);
+}
+
+bool ConfigurationStore::load()
+{
+  readObjectFromEEPROM(i2cAddress, baseAddress, mirror, CONFIGURATION_STORE_BLOCK_SIZE);
+  return validate();
+}
+
+bool ConfigurationStore::load(const void * block)
+{
+  memcpy(mirror, block, CONFIGURATION_STORE_BLOCK_SIZE);
+  return validate();
+}
+
+bool ConfigurationStore::validate()
+{
+  dirtyBytes = 0;
+
+  configuration_store_trailer trailer;
+  memcpy(&trailer, &mirror[CONFIGURATION_STORE_PAYLOAD_SIZE], sizeof(trailer));
+  if(trailer.version != CONFIGURATION_STORE_VERSION || trailer.crc != crc16(mirror, CONFIGURATION_STORE_PAYLOAD_SIZE))
+  {
+    // keep the stored bytes, callers apply defaults. the trailer is rewritten on the next commit
+    notify(F("Config crc invalid"));
+    updateTrailer();
+    return false;
+  }
+  return true;
+}
+
+void ConfigurationStore::read(void * destination, uint8_t length)
+{
+  memcpy(destination, mirror, min(length, (uint8_t) CONFIGURATION_STORE_PAYLOAD_SIZE));
+}
+
+void ConfigurationStore::write(const void * source, uint8_t length)
+{
+  markDirty(0, source, min(length, (uint8_t) CONFIGURATION_STORE_PAYLOAD_SIZE));
+  updateTrailer();
+}
+
+bool ConfigurationStore::isDirty()
+{
+  return dirtyBytes != 0;
+}
+
+void ConfigurationStore::commit()
+{
+  if(!isDirty())
+  {
+    return;
+  }
+
+  // write the dirty span of each page, clean pages are not touched
+  for(uint8_t pageStart = 0; pageStart < CONFIGURATION_STORE_BLOCK_SIZE; pageStart += EEPROM_PAGE_SIZE)
+  {
+    short first = -1;
+    short last = -1;
+    for(uint8_t i = pageStart; i < pageStart + EEPROM_PAGE_SIZE; i++)
+    {
+      if(dirtyBytes & (1ULL << i))
+      {
+        if(first == -1)
+        {
+          first = i;
+        }
+        last = i;
+      }
+    }
+    if(first != -1)
+    {
+      writeEEPROMPage(&Wire, i2cAddress, baseAddress + first, &mirror[first], last - first + 1);
+    }
+  }
+  dirtyBytes = 0;
+  debug(F("Config committed"));
+}
+
+void ConfigurationStore::markDirty(uint8_t offset, const void * source, uint8_t length)
+{
+  const byte * bytes = (const byte *) source;
+  for(uint8_t i = 0; i < length; i++)
+  {
+    if(mirror[offset + i] != bytes[i])
+    {
+      mirror[offset + i] = bytes[i];
+      dirtyBytes |= 1ULL << (offset + i);
+    }
+  }
+}
+
+void ConfigurationStore::updateTrailer()
+{
+  configuration_store_trailer trailer;
+  trailer.version = CONFIGURATION_STORE_VERSION;
+  trailer.crc = crc16(mirror, CONFIGURATION_STORE_PAYLOAD_SIZE);
+  markDirty(CONFIGURATION_STORE_PAYLOAD_SIZE, &trailer, sizeof(trailer));
+}
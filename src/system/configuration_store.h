@@ -0,0 +1,68 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_CONFIGURATION_STORE
+#define WATERBEAR_CONFIGURATION_STORE
+
+#include <Arduino.h>
+#include "eeprom.h"
+
+#define CONFIGURATION_STORE_VERSION 1
+#define CONFIGURATION_STORE_BLOCK_SIZE EEPROM_DATALOGGER_CONFIGURATION_SIZE
+
+// the last 4 bytes of the block hold the version and crc of the payload
+#define CONFIGURATION_STORE_TRAILER_SIZE 4
+#define CONFIGURATION_STORE_PAYLOAD_SIZE (CONFIGURATION_STORE_BLOCK_SIZE - CONFIGURATION_STORE_TRAILER_SIZE)
+
+typedef struct
+{
+  unsigned short version; // 2 bytes
+  unsigned short crc;     // 2 bytes
+} configuration_store_trailer;
+
+/*
+*  RAM mirror of one EEPROM configuration block
+*
+*  Writes only update the mirror and mark the changed bytes dirty.  commit() writes back
+*  the pages that contain dirty bytes, so several settings changes cost one EEPROM update.
+*/
+class ConfigurationStore
+{
+
+public:
+  ConfigurationStore(int i2cAddress, short baseAddress); // baseAddress must be page aligned
+
+  bool load(); // returns false if the stored crc or version is not valid
+  bool load(const void * block); // load from a cached copy of the block
+  void read(void * destination, uint8_t length);
+  void write(const void * source, uint8_t length);
+  bool isDirty();
+  void commit();
+
+private:
+  int i2cAddress;
+  short baseAddress;
+  byte mirror[CONFIGURATION_STORE_BLOCK_SIZE];
+  unsigned long long dirtyBytes = 0; // one bit per byte of the block
+
+  bool validate();
+  void markDirty(uint8_t offset, const void * source, uint8_t length);
+  void updateTrailer();
+};
+
+#endif
@@ -24,25 +24,81 @@
 
 void writeEEPROM(TwoWire * wire, int deviceaddress, short eeaddress, byte data )
 {
-  i2cSendTransmission(deviceaddress, eeaddress, &data, 1);
-  delay(5);
+  writeEEPROMPage(wire, deviceaddress, eeaddress, &data, 1);
 }
 
 byte readEEPROM(TwoWire * wire, int deviceaddress, short eeaddress )
 {
   byte rdata = 0xFF;
-  i2cSendTransmission(deviceaddress, eeaddress, 0, 0);
-  delay(5);
+  readEEPROMSequential(wire, deviceaddress, eeaddress, &rdata, 1);
+  return(rdata);
+}
 
-  short numBytes = wire->requestFrom(deviceaddress,1);
-  // char debugMessage[100];
-  // sprintf(debugMessage, "ee got %i bytes", numBytes);
-  // debug(debugMessage);
+bool waitForEEPROMWriteCycle(TwoWire * wire, int deviceaddress)
+{
+  // the EEPROM does not ACK its address while an internal write cycle is in progress
+  // so poll the address instead of waiting out the worst case write time
+  uint32 start = millis();
+  while(millis() - start < EEPROM_WRITE_CYCLE_TIMEOUT_MS)
+  {
+    wire->beginTransmission(deviceaddress);
+    if(wire->endTransmission() == SUCCESS)
+    {
+      return true;
+    }
+  }
+  debug(F("EEPROM write cycle timeout"));
+  return false;
+}
 
-  while(!wire->available()){} 
-  rdata = wire->read();
+bool writeEEPROMPage(TwoWire * wire, int deviceaddress, short eeaddress, const byte * data, uint8_t length)
+{
+  short rval = -1;
+  while (rval != SUCCESS)
+  {
+    wire->beginTransmission(deviceaddress);
+    wire->write((byte) eeaddress);
+    wire->write(data, length);
+    rval = wire->endTransmission();
 
-  return(rdata);
+    if(rval != SUCCESS)
+    {
+      i2cError(rval);
+      // device may still be busy with a previous write cycle
+      waitForEEPROMWriteCycle(wire, deviceaddress);
+    }
+  }
+
+  return waitForEEPROMWriteCycle(wire, deviceaddress);
+}
+
+void readEEPROMSequential(TwoWire * wire, int deviceaddress, short eeaddress, byte * data, uint8_t length)
+{
+  // set the address pointer once, then clock out bytes with sequential reads
+  // the address pointer auto increments, so chunks only need to be requested
+  i2cSendTransmission(deviceaddress, eeaddress, 0, 0);
+
+  uint8_t position = 0;
+  while(position < length)
+  {
+    uint8_t chunk = length - position;
+    if(chunk > EEPROM_READ_CHUNK_SIZE)
+    {
+      chunk = EEPROM_READ_CHUNK_SIZE;
+    }
+
+    uint8_t received = wire->requestFrom(deviceaddress, (int) chunk);
+    for(uint8_t i = 0; i < received; i++)
+    {
+      data[position + i] = wire->read();
+    }
+    if(received < chunk)
+    {
+      // bus error, restart the read from where we left off
+      i2cSendTransmission(deviceaddress, eeaddress + position + received, 0, 0);
+    }
+    position = position + received;
+  }
 }
 
 // void readDeploymentIdentifier(char * deploymentIdentifier)
@@ -66,11 +122,7 @@ byte readEEPROM(TwoWire * wire, int deviceaddress, short eeaddress )
 
 void readObjectFromEEPROM(short i2cAddress, short address, void * data, uint8_t size)
 {
-  byte * buffer = (byte *) data;
-  for (uint8_t i = 0; i < size; i++)
-  {
-    buffer[i] = readEEPROM(&Wire, i2cAddress, address+i);
-  }
+  readEEPROMSequential(&Wire, i2cAddress, address, (byte *) data, size);
 }
 
 
@@ -82,10 +134,18 @@ void readObjectFromEEPROM(short address, void * data, uint8_t size) // Little En
 void writeObjectToEEPROM(int i2cAddress, int baseAddress, void * source, int size)
 {
   byte * bytes = (byte *) source;
-  for(short i=0; i < size; i++)
+  short written = 0;
+  while(written < size)
   {
-    short address = baseAddress + i;
-    writeEEPROM(&Wire, i2cAddress, address, bytes[i]);
+    // split the object into page aligned writes
+    short address = baseAddress + written;
+    short length = EEPROM_PAGE_SIZE - (address % EEPROM_PAGE_SIZE);
+    if(length > size - written)
+    {
+      length = size - written;
+    }
+    writeEEPROMPage(&Wire, i2cAddress, address, &bytes[written], length);
+    written = written + length;
   }
 }
 
@@ -122,11 +182,7 @@ void readSensorConfigurationFromEEPROM(short slot, void * configuration)
 
 void readUniqueId(unsigned char * uuid)
 {
-  for(int i=0; i < UUID_LENGTH; i++)
-  {
-    unsigned int address = EEPROM_UUID_ADDRESS_START + i;
-    uuid[i] = readEEPROM(&Wire, EEPROM_I2C_ADDRESS, address);
-  }
+  readObjectFromEEPROM(EEPROM_UUID_ADDRESS_START, uuid, UUID_LENGTH);
 
   debug(F("UUID in EEPROM:")); // TODO: need to create another function and read from flash  
 
@@ -142,17 +198,8 @@ void readUniqueId(unsigned char * uuid)
     decodeUniqueId(uuid, uuidString, UUID_LENGTH);
     debug(uuidString);
     
-    for(int i=0; i < UUID_LENGTH; i++)
-    {
-      unsigned int address = EEPROM_UUID_ADDRESS_START + i;
-      writeEEPROM(&Wire, EEPROM_I2C_ADDRESS, address, uuid[i]);
-    }
-
-    for(int i=0; i < UUID_LENGTH; i++)
-    {
-      unsigned int address = EEPROM_UUID_ADDRESS_START + i;
-      uuid[i] = readEEPROM(&Wire, EEPROM_I2C_ADDRESS, address);
-    }
+    writeObjectToEEPROM(EEPROM_UUID_ADDRESS_START, uuid, UUID_LENGTH);
+    readObjectFromEEPROM(EEPROM_UUID_ADDRESS_START, uuid, UUID_LENGTH);
 
     debug(F("UUID in EEPROM:"));
     for(short i=0; i < UUID_LENGTH; i++)
@@ -173,10 +220,7 @@ void readUniqueId(unsigned char * uuid)
 
 void writeEEPROMBytes(short address, unsigned char * data, uint8_t size) // Little Endian
 {
-  for (uint8_t i = 0; i < size; i++)
-  {
-    writeEEPROM(&Wire, EEPROM_I2C_ADDRESS, address+i, data[i]);
-  }
+  writeObjectToEEPROM(address, data, size);
 }
 
 
@@ -184,10 +228,7 @@ void writeEEPROMBytes(short address, unsigned char * data, uint8_t size) // Litt
 
 void readEEPROMBytes(short address, unsigned char * data, uint8_t size) // Little Endian
 {
-  for (uint8_t i = 0; i < size; i++)
-  {
-    data[i] = readEEPROM(&Wire, EEPROM_I2C_ADDRESS, address+i);
-  }
+  readObjectFromEEPROM(address, data, size);
 }
 
 
@@ -226,8 +267,18 @@ void readEEPROMBytes(short address, unsigned char * data, uint8_t size) // Littl
 
 void clearEEPROMAddress(short address, uint8_t length)
 {
-  for (uint8_t i = 0; i < length; i++)
+  byte empty[EEPROM_PAGE_SIZE];
+  memset(empty, EEPROM_RESET_VALUE, EEPROM_PAGE_SIZE);
+  uint8_t cleared = 0;
+  while(cleared < length)
   {
-    writeEEPROM(&Wire, EEPROM_I2C_ADDRESS, address+i, EEPROM_RESET_VALUE);
+    short pageAddress = address + cleared;
+    uint8_t pageLength = EEPROM_PAGE_SIZE - (pageAddress % EEPROM_PAGE_SIZE);
+    if(pageLength > length - cleared)
+    {
+      pageLength = length - cleared;
+    }
+    writeEEPROMPage(&Wire, EEPROM_I2C_ADDRESS, pageAddress, empty, pageLength);
+    cleared = cleared + pageLength;
   }
 }
\ No newline at end of file
@@ -34,11 +34,20 @@
 #define EEPROM_DATALOGGER_CONFIGURATION_SIZE 64
 #define EEPROM_DATALOGGER_SENSORS_START 80
 #define EEPROM_DATALOGGER_SENSOR_SIZE 64
-#define EEPROM_TOTAL_SENSOR_SLOTS 4 // can be 12
+#define EEPROM_TOTAL_SENSOR_SLOTS 12 // 4 slots per 256 byte block, blocks 1-3
+
+#define EEPROM_PAGE_SIZE 16 // page write buffer, writes must not cross a page boundary
+#define EEPROM_READ_CHUNK_SIZE 32 // limited by the Wire rx buffer
+#define EEPROM_WRITE_CYCLE_TIMEOUT_MS 20 // datasheet max write cycle is 5ms, allow margin
 
 void writeEEPROM(TwoWire * wire, int deviceaddress, short eeaddress, byte data );
 byte readEEPROM(TwoWire * wire, int deviceaddress, short eeaddress );
 
+// page mode access, length of a page write must stay within one EEPROM_PAGE_SIZE page
+bool writeEEPROMPage(TwoWire * wire, int deviceaddress, short eeaddress, const byte * data, uint8_t length);
+void readEEPROMSequential(TwoWire * wire, int deviceaddress, short eeaddress, byte * data, uint8_t length);
+bool waitForEEPROMWriteCycle(TwoWire * wire, int deviceaddress);
+
 void readUniqueId(unsigned char * uuid); // uuid must point to char[UUID_LENGTH]
 
 void writeEEPROMBytes(short address, unsigned char * data, uint8_t size);
@@ -54,6 +63,7 @@ void readSensorConfigurationFromEEPROM(short slot, void * configuration);
 void clearEEPROMAddress(short address, uint8_t length);
 
 void writeObjectToEEPROM(int i2cAddress, int baseAddress, void * source, int size);
+void writeObjectToEEPROM(int baseAddress, void * source, int size);
 
 void readObjectFromEEPROM(short i2cAddress, short address, void * data, uint8_t size);
 void readObjectFromEEPROM(short address, void * data, uint8_t size); // Little Endian
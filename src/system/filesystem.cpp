@@ -19,6 +19,8 @@
 #include "filesystem.h"
 #include "clock.h"
 #include "monitor.h"
+#include "serial_tx.h"
+#include "trace.h"
 #include "system/logs.h"
 
 char dataDirectory[6] = "/Data";
@@ -60,7 +62,7 @@ void WaterBear_FileSystem::initializeSDCard(){
     // also produce some kind of check engine light.
     // can we do a very low current blink LED or something.
     delay(6000);
-    nvic_sys_reset();
+    resetWithReason(trace_reset_sd_failure);
   }
   else
   {
@@ -128,7 +130,7 @@ void WaterBear_FileSystem::dumpLoggedDataToStream(Stream * myStream, char * last
       //notify(sdDirName);
 
       if(! sd.chdir(sdDirName) ){
-        Serial2.write("fail:");
+        SerialOutput.write("fail:");
         notify(sdDirName);
         state = 0;
         return;
@@ -154,7 +156,7 @@ void WaterBear_FileSystem::dumpLoggedDataToStream(Stream * myStream, char * last
             // send size of transmission ?
             // notify(datafile.fileSize());
             while (datafile.available()) {
-                Serial2.write(datafile.read());
+                SerialOutput.write(datafile.read());
             }
             datafile.close();
          }
@@ -267,7 +269,7 @@ void WaterBear_FileSystem::setNewDataFile(long unixtime, char * header)
   bool success = this->openFile(filename);
   if( !success )
   {
-    Serial2.print(F("filesystem open failure"));
+    SerialOutput.print(F("filesystem open failure"));
     while(1);
   }
 
@@ -294,9 +296,52 @@ void WaterBear_FileSystem::printCurrentDirListing()
   }
 }
 
+bool WaterBear_FileSystem::listDirectory(const char * path, directory_visitor visitor, void * context)
+{
+  File directory = this->sd.open(path, O_READ);
+  if(!directory || !directory.isDir())
+  {
+    directory.close();
+    return false;
+  }
+
+  SdFile entry;
+  char name[30];
+  while(entry.openNext(&directory, O_READ))
+  {
+    entry.getName(name, sizeof(name));
+    bool more = visitor(name, entry.fileSize(), entry.isDir(), context);
+    entry.close();
+    if(!more)
+    {
+      break;
+    }
+  }
+  directory.close();
+  return true;
+}
+
+int WaterBear_FileSystem::readFile(const char * path, uint32 offset, void * buffer, unsigned short length)
+{
+  File file = this->sd.open(path, O_READ);
+  if(!file || file.isDir())
+  {
+    file.close();
+    return -1;
+  }
+
+  int count = 0; // past the end reads nothing
+  if(file.seekSet(offset))
+  {
+    count = file.read(buffer, length);
+  }
+  file.close();
+  return count;
+}
+
 void WaterBear_FileSystem::closeFileSystem()
 {
-  Serial2.print(F("Close filesystem"));
+  SerialOutput.print(F("Close filesystem"));
   //this->logfile.sync();
   this->logfile.close(); // syncs then closes
   //this->sd.end // doesn't exist
@@ -23,8 +23,17 @@
 #include "DS3231.h"
 #include "write_cache.h"
 
+#define CSV_HEADER_LENGTH 512 // status fields plus columns for every sensor slot
+
+// called for each entry by listDirectory(), return false to stop
+typedef bool (*directory_visitor)(const char * name, uint32 size, bool directory, void * context);
+
 class WaterBear_FileSystem : public OutputDevice
 {
+public:
+  // counted against memory_filesystem, the SdFat cache makes this the largest heap object
+  static void * operator new(size_t size) { return taggedMalloc(memory_filesystem, size); }
+  static void operator delete(void * pointer) { taggedFree(memory_filesystem, pointer); }
 
 private:
   // File system object.
@@ -33,7 +42,7 @@ private:
   int chipSelectPin;
   char filename[15];
   char loggingFolder[29];
-  char header[200];
+  char header[CSV_HEADER_LENGTH];
 
   void printCurrentDirListing();
   bool openFile(char * filename);
@@ -51,6 +60,10 @@ public:
   void writeString(const char * string);
   void endOfLine();
 
+  // absolute paths, neither changes the working directory the log file is in
+  bool listDirectory(const char * path, directory_visitor visitor, void * context);
+  int readFile(const char * path, uint32 offset, void * buffer, unsigned short length); // bytes read, -1 if not a file
+
 };
 
 #endif
@@ -41,6 +41,7 @@ void startSerial2()
   {
     delay(100);
   }
+  SerialOutput.begin();
   notify(F("Begin Serial2"));
 }
 
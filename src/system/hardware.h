@@ -21,9 +21,10 @@
 
 #include <Arduino.h>
 #include <Wire_slave.h> // Communicate with I2C/TWI devices
+#include "serial_tx.h"
 
-// For F103RB
-#define Serial Serial2
+// For F103RB, output is queued for the DMA
+#define Serial SerialOutput
 
 // extern TwoWire Wire;
 #define WireOne Wire 
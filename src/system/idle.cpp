@@ -0,0 +1,108 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "idle.h"
+#include "clock.h"
+#include "interrupts.h"
+#include "low_power.h"
+#include "serial_tx.h"
+#include "watchdog.h"
+
+static idle_depth_type depthLimit = idle_wfi;
+
+static void idleUntilAlarm(uint32 milliseconds, idle_depth_type depth)
+{
+  // the one alarm path, relative to the free running internal RTC counter
+  setNextAlarmInternalRTCMilliseconds(milliseconds);
+
+  int iser1, iser2, iser3;
+  storeAllInterrupts(iser1, iser2, iser3);
+
+  SerialOutput.drain(); // finish sending before the port stops
+  disableSerialLog();
+
+  clearAllInterrupts();
+  clearAllPendingInterrupts();
+
+  nvic_irq_enable(NVIC_RTCALARM); // enable our RTC alarm interrupt
+
+  uint32 sleepStartTicks = internalRTCTicks();
+  if (depth == idle_stop)
+  {
+    enterStopMode();
+  }
+  else
+  {
+    enterSleepMode();
+  }
+
+  nvic_irq_disable(NVIC_RTCALARM);
+
+  reenableAllInterrupts(iser1, iser2, iser3);
+
+  addSleepToMillis(sleepStartTicks); // systick was off, count the time measured on the RTC instead
+
+  feedWatchdog();
+  enableSerialLog();
+}
+
+void idle(uint32 milliseconds, idle_depth_type maxDepth)
+{
+  uint32 start = millis();
+  uint32 elapsed;
+  while ((elapsed = millis() - start) < milliseconds)
+  {
+    // the alarm can fire up to a tick early, the rest of the wait goes round again
+    uint32 remaining = milliseconds - elapsed;
+    if (remaining > watchdogFeedIntervalMilliseconds())
+    {
+      remaining = watchdogFeedIntervalMilliseconds(); // the watchdog keeps counting while asleep
+    }
+    idle_depth_type depth = idle_wfi;
+    if (remaining >= IDLE_STOP_MINIMUM_MILLISECONDS)
+    {
+      depth = idle_stop;
+    }
+    else if (remaining >= IDLE_SLEEP_MINIMUM_MILLISECONDS)
+    {
+      depth = idle_sleep;
+    }
+    if (depth > maxDepth)
+    {
+      depth = maxDepth;
+    }
+    if (depth > depthLimit)
+    {
+      depth = depthLimit;
+    }
+
+    if (depth == idle_wfi)
+    {
+      enterIdleMode(); // until the next SysTick
+      feedWatchdog();
+    }
+    else
+    {
+      idleUntilAlarm(remaining, depth);
+    }
+  }
+}
+
+void setIdleDepthLimit(idle_depth_type limit)
+{
+  depthLimit = limit;
+}
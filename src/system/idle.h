@@ -0,0 +1,43 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_IDLE
+#define WATERBEAR_IDLE
+
+#include <Arduino.h>
+
+#define IDLE_SLEEP_MINIMUM_MILLISECONDS 3 // shorter waits can't be timed by the RTC alarm, they stay in WFI
+#define IDLE_STOP_MINIMUM_MILLISECONDS 50 // leaving stop mode relocks the PLL and restarts the serial port
+
+typedef enum idle_depth
+{
+  idle_wfi,   // CPU clock gated, SysTick and peripherals keep running
+  idle_sleep, // PLL off, woken by the internal RTC alarm
+  idle_stop   // all high speed clocks off, woken by the internal RTC alarm
+} idle_depth_type;
+
+// Wait in the deepest state that suits the gap, without SysTick ticking where the RTC alarm can time it.
+// millis() is credited with the time spent asleep.
+// maxDepth keeps the serial port listening for waits the user may type through.
+// Requires startInternalRTC().
+void idle(uint32 milliseconds, idle_depth_type maxDepth = idle_stop);
+
+// Caps the depth of every idle() whatever its caller asks for, idle_wfi until set.
+// The datalogger allows stop mode only while logging, so the CLI is heard in the other modes.
+void setIdleDepthLimit(idle_depth_type limit);
+
+#endif
@@ -1,8 +1,116 @@
 #include "logs.h"
 #include "monitor.h"
 #include "utilities/utilities.h"
+#include <stdarg.h>
 
 
+bool debugEnabled()
+{
+  return Monitor::instance()->debugEnabled();
+}
+
+static bool appendRecordBytes(byte * record, unsigned short * length, const void * bytes, unsigned short count)
+{
+  if (*length + count > LOG_RECORD_LENGTH)
+  {
+    return false;
+  }
+  memcpy(&record[*length], bytes, count);
+  *length += count;
+  return true;
+}
+
+void debugRecord(const char * format, ...)
+{
+  if (!debugEnabled())
+  {
+    return;
+  }
+
+  va_list args;
+  va_start(args, format);
+
+  if (!Monitor::instance()->binaryRecords)
+  {
+    char message[LOG_MESSAGE_LENGTH];
+    vsnprintf(message, LOG_MESSAGE_LENGTH, format, args);
+    va_end(args);
+    debug(message);
+    return;
+  }
+
+  // no formatting, the format string stays in flash and only its address is sent
+  byte record[LOG_RECORD_LENGTH];
+  unsigned short length = LOG_RECORD_HEADER_LENGTH;
+  record[0] = LOG_RECORD_START;
+  uint32 formatAddress = (uint32) format;
+  memcpy(&record[1], &formatAddress, 4);
+
+  bool fits = true;
+  for (const char * c = format; *c != 0 && fits; c++)
+  {
+    if (*c != '%')
+    {
+      continue;
+    }
+    c++;
+    unsigned short longs = 0;
+    while (*c != 0 && strchr("-+ #0123456789.lh", *c) != NULL)
+    {
+      if (*c == 'l')
+      {
+        longs++;
+      }
+      c++;
+    }
+
+    switch (*c)
+    {
+    case 0:
+      c--; // let the loop see the terminator
+      break;
+    case '%':
+      break;
+    case 'f':
+    case 'e':
+    case 'g':
+    {
+      double value = va_arg(args, double);
+      fits = appendRecordBytes(record, &length, &value, 8);
+      break;
+    }
+    case 's':
+    {
+      const char * value = va_arg(args, const char *);
+      if (length + 1 >= LOG_RECORD_LENGTH)
+      {
+        fits = false;
+        break;
+      }
+      byte stringLength = strnlen(value, LOG_RECORD_LENGTH - length - 1); // truncated to fit
+      appendRecordBytes(record, &length, &stringLength, 1);
+      appendRecordBytes(record, &length, value, stringLength);
+      break;
+    }
+    default:
+      if (longs >= 2)
+      {
+        long long value = va_arg(args, long long);
+        fits = appendRecordBytes(record, &length, &value, 8);
+      }
+      else
+      {
+        uint32 value = va_arg(args, uint32);
+        fits = appendRecordBytes(record, &length, &value, 4);
+      }
+      break;
+    }
+  }
+  va_end(args);
+
+  record[5] = length - LOG_RECORD_HEADER_LENGTH;
+  Monitor::instance()->writeDebugRecord(record, length);
+}
 
 void debug(const char* message)
 {
@@ -16,36 +124,56 @@ void debug(const __FlashStringHelper * message)
 
 void debug(int number)
 {
-  char message[10];
-  sprintf(message, "%d", number);
+  if (!debugEnabled())
+  {
+    return;
+  }
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%d", number);
   debug(message);
 }
 
 void debug(uint32 number)
 {
-  char message[10];
-  sprintf(message, "%ld", number);
+  if (!debugEnabled())
+  {
+    return;
+  }
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%lu", number);
   debug(message);
 }
 
 void debug(short number)
 {
-  char message[10];
-  sprintf(message, "%d", number);
+  if (!debugEnabled())
+  {
+    return;
+  }
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%d", number);
   debug(message);
 }
 
 void debug(float number)
 {
-  char message[10];
-  sprintf(message, "%f", number);
+  if (!debugEnabled())
+  {
+    return;
+  }
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%f", number);
   debug(message);
 }
 
 void debug(double number)
 {
-  char message[10];
-  sprintf(message, "%f", number);
+  if (!debugEnabled())
+  {
+    return;
+  }
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%f", number);
   debug(message);
 }
 
@@ -61,37 +189,37 @@ void notify(const __FlashStringHelper * message)
 
 void notify(int number)
 {
-  char message[10];
-  sprintf(message, "%d", number);
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%d", number);
   notify(message);
 }
 
 
 void notify(unsigned int number)
 {
-  char message[10];
-  sprintf(message, "%d", number);
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%u", number);
   notify(message);
 }
 
 void notify(short number)
 {
-  char message[10];
-  sprintf(message, "%d", number);
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%d", number);
   notify(message);
 }
 
 void notify(uint32 number)
 {
-  char message[10];
-  sprintf(message, "%ld", number);
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%lu", number);
   notify(message);
 }
 
 
 void notify(double number)
 {
-  char message[10];
-  sprintf(message, "%f", number);
+  char message[LOG_NUMBER_LENGTH];
+  snprintf(message, LOG_NUMBER_LENGTH, "%f", number);
   notify(message);
-}
\ No newline at end of file
+}
@@ -3,6 +3,44 @@
 
 #include <Arduino.h>
 
+// Build time log level, calls above it compile to nothing, e.g. -DLOG_LEVEL=LOG_LEVEL_NOTIFY
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_NOTIFY 1
+#define LOG_LEVEL_DEBUG 2
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_NUMBER_LENGTH 24   // "-2147483648.000000" and friends
+#define LOG_MESSAGE_LENGTH 100 // formatted text records
+#define LOG_RECORD_LENGTH 64   // binary records, larger arguments are truncated
+
+// Binary debug record, expanded on the host by tools/log_decoder.py using the firmware ELF
+//   LOG_RECORD_START, format string address (4 bytes LE), payload length, payload
+// The payload holds the raw arguments in format order: 4 bytes for integers and chars,
+// 8 for %ll and %f, and a length byte followed by the characters for %s.
+#define LOG_RECORD_START 0x1E // ASCII record separator, never part of a text line
+#define LOG_RECORD_HEADER_LENGTH 6
+
+// Only the arguments of enabled levels are evaluated, and nothing is formatted while no sink is on.
+// LOG_DEBUGF formats as printf on the device, or defers formatting to the host when binary records are on.
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(message) do { if (debugEnabled()) { debug(message); } } while (0)
+#define LOG_DEBUGF(...) do { if (debugEnabled()) { debugRecord(__VA_ARGS__); } } while (0)
+#else
+#define LOG_DEBUG(message) do { } while (0)
+#define LOG_DEBUGF(...) do { } while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_NOTIFY
+#define LOG_NOTIFY(message) notify(message)
+#else
+#define LOG_NOTIFY(message) do { } while (0)
+#endif
+
+bool debugEnabled();
+void debugRecord(const char * format, ...);
+
 // Convienience functions
 void debug(const char*);
 void debug(const __FlashStringHelper * message);
@@ -21,4 +59,4 @@ void notify(unsigned int number);
 void notify(uint32 number);
 void notify(double number);
 
-#endif
\ No newline at end of file
+#endif
@@ -29,6 +29,7 @@
 #include <libmaple/dac.h>
 #include <libmaple/usart.h>
 #include "logs.h"
+#include "serial_tx.h"
 
 void enterStopMode()
 {
@@ -53,7 +54,7 @@ void enterStopMode()
 
   rcc_switch_sysclk(RCC_CLKSRC_HSI);
   rcc_turn_off_clk(RCC_CLK_PLL);
-  rcc_turn_off_clk(RCC_CLK_LSI);
+  // the LSI stays on, it clocks the watchdog
 
   __asm__ volatile( "dsb" ); // assembly: data synchronization barrier
   systick_disable();
@@ -73,6 +74,8 @@ void enterStopMode()
 
 void enterSleepMode()
 {
+  SCB_BASE->SCR &= ~SCB_SCR_SLEEPDEEP; // left set by enterStopMode(), would make this stop mode
+
   rcc_switch_sysclk(RCC_CLKSRC_HSI); 
   rcc_turn_off_clk(RCC_CLK_PLL);
 
@@ -87,6 +90,15 @@ void enterSleepMode()
   rcc_switch_sysclk(RCC_CLKSRC_PLL);
 }
 
+void enterIdleMode()
+{
+  SCB_BASE->SCR &= ~SCB_SCR_SLEEPDEEP;
+
+  __asm__ volatile( "dsb" );
+  __asm__ volatile( "wfi" );
+  __asm__ volatile( "isb" );
+}
+
 void componentsAlwaysOff()
 {
 
@@ -273,11 +285,9 @@ void componentsBurstMode()
   // i2c_master_enable(I2C2, I2C_BUS_RESET);
   // i2c_master_enable(I2C1, 0, 0);
   // i2c_master_enable(I2C2, 0, 0);
-  
-  pinMode(PC8, OUTPUT); // check order of operation, necessary to switch components off
-  digitalWrite(PC8, HIGH);
-  spi_peripheral_enable(SPI1);
-  
+
+  // SPI1 and the SD card select are switched on with POWER_DOMAIN_SD
+
   adc_enable(ADC1);
   ADC1->regs->CR2 |= ADC_CR2_TSVREFE; // temperature sensor inside ADC
 
@@ -295,6 +305,7 @@ void enableSerialLog()
 {
   usart_enable(Serial2.c_dev());
   Serial2.begin(SERIAL_BAUD);
+  SerialOutput.begin();
 }
 
 // Not Used
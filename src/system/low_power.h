@@ -27,6 +27,7 @@
 // public:
   void enterStopMode();
   void enterSleepMode();
+  void enterIdleMode(); // WFI only, clocks keep running
   void componentsAlwaysOff(); // turn off unused components during setup
   void hardwarePinsAlwaysOff(); // disable unused hardware pins during setup
   void componentsStopMode(); // for stop/sleep mode
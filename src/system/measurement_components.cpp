@@ -18,4 +18,17 @@
 #include "measurement_components.h"
 
 // Components
-AD7091R * externalADC;
\ No newline at end of file
+AD7091R * externalADC;
+
+void configureExternalADC()
+{
+  if (externalADC == NULL)
+  {
+    return;
+  }
+  externalADC->configure();
+  externalADC->enableChannel(0);
+  externalADC->enableChannel(1);
+  externalADC->enableChannel(2);
+  externalADC->enableChannel(3);
+}
@@ -23,4 +23,7 @@
 // Components
 extern AD7091R * externalADC;
 
+// Configure the external ADC after it comes out of reset, no-op if it isn't installed
+void configureExternalADC();
+
 #endif
\ No newline at end of file
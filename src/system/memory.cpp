@@ -0,0 +1,183 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "memory.h"
+#include <malloc.h>
+#include <libmaple/libmaple.h>
+#include <libmaple/scb.h>
+#include "logs.h"
+#include "sensors/driver_pool.h"
+
+extern "C" char * _sbrk(int incr);
+extern "C" void * __real_malloc(size_t size);
+extern "C" void __real_free(void * pointer);
+extern "C" void * __real_realloc(void * pointer, size_t size);
+extern "C" void * __real_calloc(size_t count, size_t size);
+
+static uint32 heapInUse = 0;
+static uint32 heapPeak = 0;
+static uint32 allocationFailures = 0;
+static uint32 tagged[memory_tag_count];
+static char * paintedFrom = NULL;
+
+static void subtractClamped(uint32 &total, uint32 amount)
+{
+  // newlib frees blocks it allocated internally through free() too
+  total = amount > total ? 0 : total - amount;
+}
+
+static void countAllocation(void * pointer, size_t size)
+{
+  if (pointer == NULL)
+  {
+    if (size > 0)
+    {
+      allocationFailures++;
+    }
+    return;
+  }
+  heapInUse += malloc_usable_size(pointer);
+  if (heapInUse > heapPeak)
+  {
+    heapPeak = heapInUse;
+  }
+}
+
+extern "C" void * __wrap_malloc(size_t size)
+{
+  void * pointer = __real_malloc(size);
+  countAllocation(pointer, size);
+  return pointer;
+}
+
+extern "C" void __wrap_free(void * pointer)
+{
+  if (pointer != NULL)
+  {
+    subtractClamped(heapInUse, malloc_usable_size(pointer));
+  }
+  __real_free(pointer);
+}
+
+extern "C" void * __wrap_realloc(void * pointer, size_t size)
+{
+  uint32 before = pointer != NULL ? malloc_usable_size(pointer) : 0;
+  void * result = __real_realloc(pointer, size);
+  if (result == NULL && size > 0)
+  {
+    allocationFailures++; // the old block is untouched
+    return NULL;
+  }
+  subtractClamped(heapInUse, before);
+  countAllocation(result, size);
+  return result;
+}
+
+extern "C" void * __wrap_calloc(size_t count, size_t size)
+{
+  void * pointer = __real_calloc(count, size);
+  countAllocation(pointer, count * size);
+  return pointer;
+}
+
+void * taggedMalloc(memory_tag_type tag, size_t size)
+{
+  void * pointer = malloc(size);
+  if (pointer != NULL)
+  {
+    tagged[tag] += malloc_usable_size(pointer);
+  }
+  return pointer;
+}
+
+void taggedFree(memory_tag_type tag, void * pointer)
+{
+  if (pointer != NULL)
+  {
+    subtractClamped(tagged[tag], malloc_usable_size(pointer));
+  }
+  free(pointer);
+}
+
+static char * stackTop()
+{
+  return (char *) *(uint32 *) SCB_BASE->VTOR; // the initial stack pointer heads the vector table
+}
+
+static void __attribute__((noinline)) paintStack()
+{
+  char marker;
+  char * bottom = _sbrk(0);
+  char * end = &marker - 64; // clear of this frame and anything it calls
+  for (char * p = bottom; p < end; p++)
+  {
+    *p = MEMORY_STACK_PAINT;
+  }
+  paintedFrom = bottom;
+}
+
+void startMemoryAccounting()
+{
+  paintStack();
+}
+
+void getMemoryStatistics(memory_statistics_type * statistics)
+{
+  char marker;
+  char * heapTop = _sbrk(0);
+
+  // the deepest the stack reached is the lowest byte no longer holding the paint
+  char * deepest = heapTop > paintedFrom ? heapTop : paintedFrom;
+  while (deepest < &marker && *deepest == (char) MEMORY_STACK_PAINT)
+  {
+    deepest++;
+  }
+
+  struct mallinfo info = mallinfo();
+
+  statistics->heapInUse = heapInUse;
+  statistics->heapPeak = heapPeak;
+  statistics->heapArena = info.arena;
+  statistics->heapFreeInside = info.fordblks;
+  statistics->freeChunks = info.ordblks;
+  statistics->allocationFailures = allocationFailures;
+  statistics->stackPeak = paintedFrom != NULL ? stackTop() - deepest : 0;
+  statistics->gap = &marker - heapTop;
+  for (unsigned short i = 0; i < memory_tag_count; i++)
+  {
+    statistics->tagged[i] = tagged[i];
+  }
+  statistics->driverCells = driverCellsInUse();
+}
+
+void formatMemoryStatistics(char * buffer, size_t length)
+{
+  memory_statistics_type statistics;
+  getMemoryStatistics(&statistics);
+  snprintf(buffer, length, "heap %lu peak %lu arena %lu free %lu/%lu stack %lu gap %d fs %lu drivers %u/%u failed %lu",
+           statistics.heapInUse, statistics.heapPeak, statistics.heapArena,
+           statistics.heapFreeInside, statistics.freeChunks, statistics.stackPeak, statistics.gap,
+           statistics.tagged[memory_filesystem],
+           statistics.driverCells, DRIVER_POOL_CELL_COUNT, statistics.allocationFailures);
+}
+
+void printMemoryStatistics()
+{
+  char buffer[MEMORY_STATUS_LENGTH];
+  formatMemoryStatistics(buffer, sizeof(buffer));
+  notify(buffer);
+}
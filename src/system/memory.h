@@ -0,0 +1,65 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_MEMORY
+#define WATERBEAR_MEMORY
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// Heap, stack and per subsystem memory use, for sizing buffers against the
+// reset threshold in checkMemory().
+// The heap figures come from malloc/free/realloc/calloc wrapped at link time (-Wl,--wrap, see platformio.ini).
+#define MEMORY_STACK_PAINT 0xC5 // stack bytes below this were never reached
+#define MEMORY_STATUS_INTERVAL_SECONDS 3600 // memory rows in the data file while logging
+#define MEMORY_STATUS_LENGTH 160
+
+typedef enum memory_tag
+{
+  memory_filesystem, // WaterBear_FileSystem with its SdFat cache, and the write cache
+  memory_tag_count
+} memory_tag_type;
+
+typedef struct memory_statistics
+{
+  uint32 heapInUse;      // bytes in allocated blocks now
+  uint32 heapPeak;       // most bytes in allocated blocks at once since boot
+  uint32 heapArena;      // bytes the heap has taken from the stack gap, it never gives them back
+  uint32 heapFreeInside; // free bytes below the top of the heap, fragmentation
+  uint32 freeChunks;     // how many pieces heapFreeInside is in
+  uint32 allocationFailures;
+  uint32 stackPeak;      // deepest the stack has been since startMemoryAccounting()
+  int gap;               // between the top of the heap and the stack pointer, what freeMemory() reports
+  uint32 tagged[memory_tag_count];
+  unsigned short driverCells; // drivers live in the driver pool, not the heap
+} memory_statistics_type;
+
+// Paints the unused stack, first thing in setup()
+void startMemoryAccounting();
+
+// Scans the painted stack, takes a few hundred microseconds
+void getMemoryStatistics(memory_statistics_type * statistics);
+
+void printMemoryStatistics();
+
+// One line without commas, for a data file column
+void formatMemoryStatistics(char * buffer, size_t length);
+
+void * taggedMalloc(memory_tag_type tag, size_t size);
+void taggedFree(memory_tag_type tag, void * pointer);
+
+#endif
@@ -17,6 +17,7 @@
  */
 
 #include "monitor.h"
+#include "serial_tx.h"
 #include "utilities/utilities.h"
 
 
@@ -32,8 +33,7 @@ Monitor::Monitor() {}
 
 void Monitor::writeSerialMessage(const char *message)
 {
-  Serial2.println(message);
-  Serial2.flush();
+  SerialOutput.println(message);
 }
 
 // void Monitor::writeSerialMessage(const __FlashStringHelper *message)
@@ -54,6 +54,20 @@ void Monitor::writeDebugMessage(const char *message)
   }
 }
 
+void Monitor::writeDebugRecord(const byte *record, unsigned short length)
+{
+  // binary records only go to serial, the host expands them
+  if (this->debugToSerial)
+  {
+    SerialOutput.write(record, length);
+  }
+}
+
+bool Monitor::debugEnabled()
+{
+  return this->debugToSerial || (this->debugToFile && this->filesystem != NULL);
+}
+
 // void Monitor::writeDebugMessage(const int number)
 // {
 //   char message[10];
@@ -27,6 +27,7 @@ class Monitor
 public:
     bool debugToFile = false;
     bool debugToSerial = false;
+    bool binaryRecords = false; // LOG_DEBUGF sends unformatted records, see logs.h
     WaterBear_FileSystem * filesystem = NULL;
 
 public:
@@ -37,6 +38,8 @@ public:
     void writeSerialMessage(const char * message);
     // void writeSerialMessage(const __FlashStringHelper * message);
     void writeDebugMessage(const char * message);
+    void writeDebugRecord(const byte * record, unsigned short length);
+    bool debugEnabled();
     // void writeDebugMessage(const __FlashStringHelper * message);
     // void writeDebugMessage(int message);
     // void writeDebugMessage(int message, int base);
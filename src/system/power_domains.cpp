@@ -0,0 +1,205 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "power_domains.h"
+#include "hardware.h"
+#include "idle.h"
+#include "logs.h"
+#include "measurement_components.h"
+#include "switched_power.h"
+#include "trace.h"
+
+typedef struct power_domain_type
+{
+  unsigned short dependencies; // every domain that must be on first, including indirect ones
+  unsigned short settleMilliseconds;
+  void (*on)();
+  void (*off)();
+  void (*ready)(); // after the domain has settled, may be NULL
+} power_domain;
+
+static void boosterOn()
+{
+  gpioPinOn(GPIO_PIN_3);
+}
+
+static void boosterOff()
+{
+  gpioPinOff(GPIO_PIN_3);
+}
+
+static void i2c2On()
+{
+  // enableI2C2() without its fixed delay and bus scan, the settle time covers the delay
+  i2c_disable(I2C2);
+  i2c_master_enable(I2C2, 0, 0);
+  WireTwo.begin();
+}
+
+static void i2c2Off()
+{
+  i2c_disable(I2C2);
+}
+
+static void sdOn()
+{
+  pinMode(SD_ENABLE_PIN, OUTPUT);
+  digitalWrite(SD_ENABLE_PIN, HIGH);
+  spi_peripheral_enable(SPI1);
+}
+
+static void sdOff()
+{
+  pinMode(SD_ENABLE_PIN, OUTPUT); // necessary to switch the card off
+  digitalWrite(SD_ENABLE_PIN, LOW);
+  spi_peripheral_disable(SPI1);
+}
+
+static void externalADCOn()
+{
+  pinMode(EXADC_RESET, OUTPUT);
+  delay(1); // delay > 50ns before applying ADC reset
+  digitalWrite(EXADC_RESET, LOW); // reset is active low
+  delay(1); // delay > 10ns after starting ADC reset
+  digitalWrite(EXADC_RESET, HIGH);
+}
+
+static void externalADCOff()
+{
+  digitalWrite(EXADC_RESET, LOW);
+}
+
+// In dependency order, a domain only depends on domains before it
+static const power_domain powerDomains[POWER_DOMAIN_COUNT] = {
+  { 0,                                             500, enableSwitchedPower, disableSwitchedPower, NULL },
+  { POWER_DOMAIN_SWITCHED,                         250, boosterOn,           boosterOff,           NULL },
+  { POWER_DOMAIN_SWITCHED,                         250, i2c2On,              i2c2Off,              NULL },
+  { POWER_DOMAIN_SWITCHED,                         0,   sdOn,                sdOff,                NULL },
+  { POWER_DOMAIN_SWITCHED | POWER_DOMAIN_BOOSTER,  100, externalADCOn,       externalADCOff,       configureExternalADC },
+};
+
+static unsigned short holders[POWER_DOMAIN_COUNT];
+static uint32 settledAt[POWER_DOMAIN_COUNT];
+
+static unsigned short withDependencies(unsigned short domains)
+{
+  unsigned short all = domains;
+  for (unsigned short i = 0; i < POWER_DOMAIN_COUNT; i++)
+  {
+    if (domains & (1 << i))
+    {
+      all |= powerDomains[i].dependencies;
+    }
+  }
+  return all;
+}
+
+static void waitUntilSettled(unsigned short index)
+{
+  long remaining = (long)(settledAt[index] - millis());
+  if (remaining > 0)
+  {
+    idle(remaining);
+  }
+}
+
+void acquirePowerDomains(unsigned short domains)
+{
+  domains = withDependencies(domains);
+
+  // switch on in order, each domain only waits for its own dependencies to settle
+  // so the settle times of independent domains overlap
+  unsigned short switchedOn = 0;
+  for (unsigned short i = 0; i < POWER_DOMAIN_COUNT; i++)
+  {
+    if (!(domains & (1 << i)))
+    {
+      continue;
+    }
+    if (holders[i]++ > 0)
+    {
+      continue;
+    }
+    for (unsigned short j = 0; j < i; j++)
+    {
+      if (powerDomains[i].dependencies & (1 << j))
+      {
+        waitUntilSettled(j);
+      }
+    }
+    debug(F("Power domain on"));
+    debug(i);
+    trace(trace_power_on, 1 << i);
+    powerDomains[i].on();
+    settledAt[i] = millis() + powerDomains[i].settleMilliseconds;
+    switchedOn |= (1 << i);
+  }
+
+  for (unsigned short i = 0; i < POWER_DOMAIN_COUNT; i++)
+  {
+    if (domains & (1 << i))
+    {
+      waitUntilSettled(i);
+    }
+    if ((switchedOn & (1 << i)) && powerDomains[i].ready != NULL)
+    {
+      powerDomains[i].ready();
+    }
+  }
+}
+
+void releasePowerDomains(unsigned short domains)
+{
+  domains = withDependencies(domains);
+
+  // switch off in reverse order, dependents before the domains they need
+  for (short i = POWER_DOMAIN_COUNT - 1; i >= 0; i--)
+  {
+    if (!(domains & (1 << i)) || holders[i] == 0)
+    {
+      continue;
+    }
+    if (--holders[i] == 0)
+    {
+      debug(F("Power domain off"));
+      debug(i);
+      trace(trace_power_off, 1 << i);
+      powerDomains[i].off();
+    }
+  }
+}
+
+bool powerDomainIsOn(unsigned short domain)
+{
+  for (unsigned short i = 0; i < POWER_DOMAIN_COUNT; i++)
+  {
+    if (domain & (1 << i))
+    {
+      return holders[i] > 0;
+    }
+  }
+  return false;
+}
+
+void powerOffAllPowerDomains()
+{
+  for (short i = POWER_DOMAIN_COUNT - 1; i >= 0; i--)
+  {
+    holders[i] = 0;
+    powerDomains[i].off();
+  }
+}
@@ -0,0 +1,42 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_POWER_DOMAINS
+#define WATERBEAR_POWER_DOMAINS
+
+#include <Arduino.h>
+
+// Power domains, as bits so drivers can declare several at once.
+// Each domain turns on its dependencies first, so a driver only names the domains it uses directly.
+#define POWER_DOMAIN_SWITCHED     0x01 // switched 3v3 rail, sensors and EEPROM
+#define POWER_DOMAIN_BOOSTER      0x02 // 5v booster, external ADC reference
+#define POWER_DOMAIN_I2C2         0x04 // I2C2 bus to the sensor connectors
+#define POWER_DOMAIN_SD           0x08 // SPI1 and the SD card select
+#define POWER_DOMAIN_EXTERNAL_ADC 0x10 // AD7091R, out of reset and configured
+#define POWER_DOMAIN_COUNT 5
+#define POWER_DOMAIN_ALL 0x1F
+
+// Reference counted, each acquire must be matched by a release of the same domains.
+// Acquire returns once every requested domain has settled.
+void acquirePowerDomains(unsigned short domains);
+void releasePowerDomains(unsigned short domains);
+bool powerDomainIsOn(unsigned short domain);
+
+// Switch everything off regardless of the holders, for the stop mode fallback paths
+void powerOffAllPowerDomains();
+
+#endif
@@ -0,0 +1,98 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "sample_stream.h"
+#include "binary_protocol.h"
+#include "serial_tx.h"
+#include "eeprom.h"
+
+void SampleStream::start(unsigned short slotMask)
+{
+  slots = slotMask;
+  sequence = 0;
+  dropped = 0;
+}
+
+void SampleStream::stop()
+{
+  slots = 0;
+}
+
+bool SampleStream::active()
+{
+  return slots != 0;
+}
+
+bool SampleStream::selected(unsigned short slot)
+{
+  return slots & (1 << slot);
+}
+
+unsigned short SampleStream::describe(SensorDriver ** slotDrivers, byte * body, unsigned short capacity)
+{
+  unsigned short length = 0;
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if (!selected(slot) || slotDrivers[slot] == NULL)
+    {
+      continue;
+    }
+    const char * headers = slotDrivers[slot]->getCSVColumnHeaders();
+    unsigned short entryLength = 1 + strlen(headers) + 1;
+    if (length + entryLength > capacity)
+    {
+      break;
+    }
+    body[length++] = slot + 1;
+    strcpy((char *) body + length, headers);
+    length += strlen(headers) + 1;
+  }
+  return length;
+}
+
+void SampleStream::send(SensorDriver * driver, uint32 capturedAt)
+{
+  byte packet[BINARY_STREAM_SAMPLE_LENGTH + BINARY_CRC_LENGTH];
+  float values[SENSOR_MAX_RAW_VALUES];
+  byte count = driver->getRawValues(values);
+
+  packet[0] = binary_stream_sample;
+  binaryWriteLittleEndian(packet + 1, sequence++, 4);
+  binaryWriteLittleEndian(packet + 5, capturedAt, 4);
+  packet[9] = driver->getSlot() + 1;
+  packet[10] = count;
+  memcpy(packet + 11, values, count * sizeof(float)); // little endian IEEE 754, as the host reads them
+  unsigned short length = 11 + count * sizeof(float);
+
+  if (SerialOutput.availableForWrite() < BINARY_FRAME_LENGTH(length))
+  {
+    dropped++;
+    return;
+  }
+  writeBinaryFrame(SerialOutput, packet, length);
+}
+
+uint32 SampleStream::sentCount()
+{
+  return sequence - dropped;
+}
+
+uint32 SampleStream::droppedCount()
+{
+  return dropped;
+}
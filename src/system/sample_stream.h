@@ -0,0 +1,54 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_SAMPLE_STREAM
+#define WATERBEAR_SAMPLE_STREAM
+
+#include <Arduino.h>
+#include "sensors/sensor.h"
+
+// High rate sample streaming over the binary protocol, for bench calibration and probe response tests.
+// Each sample is one event frame, see binary_stream_sample in binary_protocol.h.  A sample is only
+// queued if the whole frame fits in SerialOutput, otherwise it is dropped and its sequence number
+// skipped, so the stream runs as fast as the sensors allow until the baud rate is the limit
+// and the host sees every loss as a gap.
+class SampleStream
+{
+public:
+  // slots selected by bit
+  void start(unsigned short slotMask);
+  void stop();
+  bool active();
+  bool selected(unsigned short slot);
+
+  // slot and column headers of each selected sensor, returns the body length
+  unsigned short describe(SensorDriver ** slotDrivers, byte * body, unsigned short capacity);
+
+  // the driver's last measurement, captured at millis() capturedAt
+  void send(SensorDriver * driver, uint32 capturedAt);
+
+  uint32 sentCount();
+  uint32 droppedCount();
+
+private:
+  unsigned short slots = 0;
+  uint32 sequence = 0;
+  uint32 dropped = 0;
+};
+
+#endif
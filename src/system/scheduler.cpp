@@ -0,0 +1,116 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "scheduler.h"
+
+Scheduler::Scheduler()
+{
+  clear();
+}
+
+void Scheduler::clear()
+{
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    removeSchedule(slot);
+  }
+}
+
+void Scheduler::setSchedule(unsigned short slot, unsigned long intervalSeconds, unsigned long offsetSeconds)
+{
+  if (slot >= EEPROM_TOTAL_SENSOR_SLOTS || intervalSeconds == 0)
+  {
+    return;
+  }
+  intervals[slot] = intervalSeconds;
+  offsets[slot] = offsetSeconds % intervalSeconds;
+  deadlines[slot] = SCHEDULER_NO_DEADLINE;
+}
+
+void Scheduler::removeSchedule(unsigned short slot)
+{
+  if (slot >= EEPROM_TOTAL_SENSOR_SLOTS)
+  {
+    return;
+  }
+  intervals[slot] = 0;
+  offsets[slot] = 0;
+  deadlines[slot] = SCHEDULER_NO_DEADLINE;
+}
+
+bool Scheduler::isScheduled(unsigned short slot)
+{
+  return slot < EEPROM_TOTAL_SENSOR_SLOTS && intervals[slot] > 0;
+}
+
+void Scheduler::start(time_t now)
+{
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if (isScheduled(slot))
+    {
+      deadlines[slot] = nextBoundary(slot, now);
+    }
+  }
+}
+
+time_t Scheduler::nextDeadline()
+{
+  time_t next = SCHEDULER_NO_DEADLINE;
+  for (unsigned short slot = 0; slot < EEPROM_TOTAL_SENSOR_SLOTS; slot++)
+  {
+    if (deadlines[slot] < next)
+    {
+      next = deadlines[slot];
+    }
+  }
+  return next;
+}
+
+bool Scheduler::isDue(unsigned short slot, time_t now)
+{
+  if (!isScheduled(slot) || deadlines[slot] == SCHEDULER_NO_DEADLINE)
+  {
+    return false;
+  }
+  return deadlines[slot] <= now + SCHEDULER_DUE_TOLERANCE_SECONDS;
+}
+
+void Scheduler::advance(unsigned short slot, time_t now)
+{
+  if (!isScheduled(slot))
+  {
+    return;
+  }
+  time_t from = deadlines[slot];
+  if (from == SCHEDULER_NO_DEADLINE || from < now)
+  {
+    from = now;
+  }
+  deadlines[slot] = nextBoundary(slot, from);
+}
+
+time_t Scheduler::nextBoundary(unsigned short slot, time_t after)
+{
+  // boundaries are at multiples of the interval since the epoch, shifted by the offset
+  // e.g. interval 900, offset 60 wakes at hh:01, hh:16, hh:31, hh:46
+  unsigned long interval = intervals[slot];
+  unsigned long offset = offsets[slot];
+  unsigned long shifted = (unsigned long) after - offset;
+  return (time_t) ((shifted / interval + 1) * interval + offset);
+}
@@ -0,0 +1,55 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_SCHEDULER
+#define WATERBEAR_SCHEDULER
+
+#include <Arduino.h>
+#include <time.h>
+#include "eeprom.h"
+
+#define SCHEDULER_NO_DEADLINE ((time_t) 0x7FFFFFFF)
+#define SCHEDULER_DUE_TOLERANCE_SECONDS 1 // the RTC alarm can fire just before the DS3231 second ticks over
+
+// Deadline table with one entry per sensor slot.
+// Each slot samples every interval seconds, offset seconds after the interval boundary,
+// and the next wake is the earliest deadline of all scheduled slots.
+class Scheduler
+{
+public:
+  Scheduler();
+
+  void clear();
+  void setSchedule(unsigned short slot, unsigned long intervalSeconds, unsigned long offsetSeconds);
+  void removeSchedule(unsigned short slot);
+  bool isScheduled(unsigned short slot);
+
+  void start(time_t now);                          // align every deadline to the next boundary after now
+  time_t nextDeadline();                           // earliest deadline, SCHEDULER_NO_DEADLINE if nothing is scheduled
+  bool isDue(unsigned short slot, time_t now);
+  void advance(unsigned short slot, time_t now);   // move a due slot to its next boundary, skipping any missed ones
+
+private:
+  unsigned long intervals[EEPROM_TOTAL_SENSOR_SLOTS]; // seconds, 0 when the slot is not scheduled
+  unsigned long offsets[EEPROM_TOTAL_SENSOR_SLOTS];   // seconds
+  time_t deadlines[EEPROM_TOTAL_SENSOR_SLOTS];
+
+  time_t nextBoundary(unsigned short slot, time_t after);
+};
+
+#endif
@@ -0,0 +1,175 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "serial_tx.h"
+#include <libmaple/dma.h>
+#include <libmaple/usart.h>
+#include "low_power.h"
+
+BufferedSerial SerialOutput(Serial2);
+
+// written by write(), emptied into the transfer buffer by startTransfer()
+static byte ring[SERIAL_TX_BUFFER_SIZE];
+static volatile unsigned short head = 0;
+static volatile unsigned short tail = 0;
+
+// the DMA reads from here so the ring can refill while a transfer runs
+static byte transfer[SERIAL_TX_TRANSFER_SIZE];
+static volatile bool transferring = false;
+static bool attached = false;
+
+static unsigned short queued()
+{
+  return (head + SERIAL_TX_BUFFER_SIZE - tail) % SERIAL_TX_BUFFER_SIZE;
+}
+
+BufferedSerial::BufferedSerial(HardwareSerial &port) : port(port) {}
+
+void BufferedSerial::begin()
+{
+  usart_dev * usart = port.c_dev();
+  dma_init(DMA1);
+  dma_setup_transfer(DMA1, DMA_CH7, &usart->regs->DR, DMA_SIZE_8BITS,
+                     transfer, DMA_SIZE_8BITS, (DMA_MINC_MODE | DMA_FROM_MEM | DMA_TRNS_CMPLT));
+  dma_attach_interrupt(DMA1, DMA_CH7, BufferedSerial::transferComplete);
+  usart->regs->CR3 |= USART_CR3_DMAT;
+  attached = true;
+
+  // anything queued before the port was up
+  noInterrupts();
+  if (!transferring)
+  {
+    startTransfer();
+  }
+  interrupts();
+}
+
+serial_tx_policy_type BufferedSerial::setPolicy(serial_tx_policy_type policy)
+{
+  serial_tx_policy_type previous = this->policy;
+  this->policy = policy;
+  return previous;
+}
+
+void BufferedSerial::drain()
+{
+  if (!attached)
+  {
+    return;
+  }
+  while (transferring)
+  {
+    enterIdleMode(); // woken by the transfer complete interrupt
+  }
+  while (!(port.c_dev()->regs->SR & USART_SR_TC)) {} // last byte out of the shift register
+}
+
+uint32 BufferedSerial::droppedBytes()
+{
+  return dropped;
+}
+
+int BufferedSerial::availableForWrite()
+{
+  return SERIAL_TX_BUFFER_SIZE - 1 - queued();
+}
+
+size_t BufferedSerial::write(uint8 byte)
+{
+  while (queued() == SERIAL_TX_BUFFER_SIZE - 1)
+  {
+    if (policy == serial_tx_drop || !attached)
+    {
+      dropped++;
+      return 0;
+    }
+    else if (policy == serial_tx_overwrite)
+    {
+      noInterrupts();
+      if (queued() == SERIAL_TX_BUFFER_SIZE - 1)
+      {
+        tail = (tail + 1) % SERIAL_TX_BUFFER_SIZE;
+        dropped++;
+      }
+      interrupts();
+    }
+    else
+    {
+      enterIdleMode(); // the transfer complete interrupt makes room
+    }
+  }
+
+  ring[head] = byte;
+  head = (head + 1) % SERIAL_TX_BUFFER_SIZE;
+
+  if (attached && !transferring)
+  {
+    noInterrupts();
+    if (!transferring)
+    {
+      startTransfer();
+    }
+    interrupts();
+  }
+  return 1;
+}
+
+int BufferedSerial::available()
+{
+  return port.available();
+}
+
+int BufferedSerial::read()
+{
+  return port.read();
+}
+
+int BufferedSerial::peek()
+{
+  return port.peek();
+}
+
+void BufferedSerial::flush()
+{
+  drain();
+}
+
+// called with interrupts off or from the DMA interrupt
+void BufferedSerial::startTransfer()
+{
+  unsigned short count = 0;
+  while (tail != head && count < SERIAL_TX_TRANSFER_SIZE)
+  {
+    transfer[count++] = ring[tail];
+    tail = (tail + 1) % SERIAL_TX_BUFFER_SIZE;
+  }
+  if (count == 0)
+  {
+    transferring = false;
+    return;
+  }
+
+  dma_disable(DMA1, DMA_CH7); // the count can only be set while the channel is off
+  dma_set_num_transfers(DMA1, DMA_CH7, count);
+  transferring = true;
+  dma_enable(DMA1, DMA_CH7);
+}
+
+void BufferedSerial::transferComplete()
+{
+  startTransfer();
+}
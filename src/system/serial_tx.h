@@ -0,0 +1,74 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_SERIAL_TX
+#define WATERBEAR_SERIAL_TX
+
+#include <Arduino.h>
+
+#define SERIAL_TX_BUFFER_SIZE 1024 // ~90ms of output at 115200 baud
+#define SERIAL_TX_TRANSFER_SIZE 64 // bytes handed to the DMA per transfer
+
+typedef enum serial_tx_policy
+{
+  serial_tx_block,    // wait for the DMA to make room
+  serial_tx_drop,     // discard the new bytes
+  serial_tx_overwrite // discard the oldest queued bytes
+} serial_tx_policy_type;
+
+// Serial2 with transmission queued in a ring buffer and sent by DMA1 channel 7,
+// so prints return without waiting on the baud rate.  Reads go straight to Serial2.
+// All output to Serial2 should go through SerialOutput, direct writes would interleave with the DMA.
+class BufferedSerial : public Stream
+{
+public:
+  BufferedSerial(HardwareSerial &port);
+
+  // attach the DMA to the USART, after the port is begun and again after it is restarted
+  void begin();
+
+  // returns the previous policy
+  serial_tx_policy_type setPolicy(serial_tx_policy_type policy);
+
+  // wait until everything queued has left the USART, before the port or clocks are stopped
+  void drain();
+
+  // bytes discarded by the drop and overwrite policies since startup
+  uint32 droppedBytes();
+
+  // bytes that can be queued now without waiting or dropping
+  int availableForWrite();
+
+  size_t write(uint8 byte);
+  using Print::write;
+  int available();
+  int read();
+  int peek();
+  void flush(); // same as drain()
+
+private:
+  static void startTransfer();
+  static void transferComplete();
+
+  HardwareSerial &port;
+  serial_tx_policy_type policy = serial_tx_block;
+  uint32 dropped = 0;
+};
+
+extern BufferedSerial SerialOutput;
+
+#endif
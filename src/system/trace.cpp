@@ -0,0 +1,147 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "trace.h"
+#include <libmaple/libmaple.h>
+#include <libmaple/rcc.h>
+#include <libmaple/nvic.h>
+#include "filesystem.h"
+#include "logs.h"
+
+// .noinit is a NOLOAD region at the top of RAM in ld/stm32f103rb_noinit.ld, it isn't zeroed at startup
+trace_ring_type traceRing __attribute__((section(".noinit")));
+
+static uint32 previousNext = 0; // where the events before this boot end
+static trace_reset_type lastReset = trace_reset_power_on;
+static bool reported = false;
+
+static const char * const eventNames[trace_event_count] = {
+  "boot",
+  "reset_requested",
+  "watchdog_phase",
+  "power_on",
+  "power_off",
+  "sleep",
+  "wake",
+  "measure",
+  "filesystem_open",
+  "filesystem_close",
+  "battery_tier",
+  "low_memory"
+};
+
+static const char * const resetNames[] = {
+  "power_on",
+  "pin",
+  "watchdog",
+  "window_watchdog",
+  "low_power",
+  "software",
+  "low_memory",
+  "sd_failure",
+  "command"
+};
+
+static trace_reset_type readResetCause()
+{
+  uint32 flags = RCC_BASE->CSR;
+  if (flags & RCC_CSR_IWDGRSTF)
+  {
+    return trace_reset_watchdog;
+  }
+  if (flags & RCC_CSR_WWDGRSTF)
+  {
+    return trace_reset_window_watchdog;
+  }
+  if (flags & RCC_CSR_LPWRRSTF)
+  {
+    return trace_reset_low_power;
+  }
+  if (flags & RCC_CSR_SFTRSTF)
+  {
+    return trace_reset_software;
+  }
+  if (flags & RCC_CSR_PORRSTF)
+  {
+    return trace_reset_power_on;
+  }
+  return trace_reset_pin;
+}
+
+void startTrace()
+{
+  lastReset = readResetCause();
+  if (traceRing.magic != TRACE_MAGIC || lastReset == trace_reset_power_on)
+  {
+    // RAM held nothing over
+    memset(&traceRing, 0, sizeof(traceRing));
+    traceRing.magic = TRACE_MAGIC;
+  }
+  else if (lastReset == trace_reset_software
+           && traceRing.requestedReset > trace_reset_software
+           && traceRing.requestedReset <= trace_reset_command)
+  {
+    lastReset = (trace_reset_type) traceRing.requestedReset;
+  }
+  traceRing.requestedReset = trace_reset_software;
+
+  previousNext = traceRing.next;
+  trace(trace_boot, lastReset);
+}
+
+static void reportLine(WaterBear_FileSystem * fileSystem, const char * line)
+{
+  notify(line);
+  if (fileSystem != NULL)
+  {
+    fileSystem->writeString(line);
+    fileSystem->endOfLine();
+  }
+}
+
+void reportTrace(WaterBear_FileSystem * fileSystem)
+{
+  if (reported)
+  {
+    return; // once per boot, the events since are this run's
+  }
+  reported = true;
+
+  char line[48];
+  snprintf(line, sizeof(line), "reset,%s", resetNames[lastReset]);
+  reportLine(fileSystem, line);
+
+  // the oldest events before the reset may already be overwritten by this run
+  uint32 written = traceRing.next - previousNext;
+  uint32 count = previousNext < TRACE_ENTRY_COUNT ? previousNext : TRACE_ENTRY_COUNT;
+  count = written >= count ? 0 : count - written;
+
+  for (uint32 i = previousNext - count; i != previousNext; i++)
+  {
+    trace_entry_type &entry = traceRing.entries[i % TRACE_ENTRY_COUNT];
+    const char * name = entry.event < trace_event_count ? eventNames[entry.event] : "unknown";
+    snprintf(line, sizeof(line), "trace,%lu,%s,%u", entry.milliseconds, name, entry.payload);
+    reportLine(fileSystem, line);
+  }
+}
+
+void resetWithReason(trace_reset_type reason)
+{
+  traceRing.requestedReset = reason;
+  trace(trace_reset_requested, reason);
+  nvic_sys_reset();
+}
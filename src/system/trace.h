@@ -0,0 +1,97 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_TRACE
+#define WATERBEAR_TRACE
+
+#include <Arduino.h>
+
+class WaterBear_FileSystem;
+
+// Binary event ring kept in RAM that the startup code doesn't clear, so the last
+// events before a watchdog or software reset can be reported on the next boot.
+// Recording is a few stores, cheap enough to leave on in deployment.
+
+#define TRACE_ENTRY_COUNT 32 // power of 2, 8 bytes each
+#define TRACE_MAGIC 0x54524331 // the ring survived the reset, not power on noise
+
+typedef enum trace_event
+{
+  trace_boot,            // payload: trace_reset_type of the reset just taken
+  trace_reset_requested, // payload: trace_reset_type
+  trace_watchdog_phase,  // payload: watchdog_phase_type
+  trace_power_on,        // payload: power domain bits
+  trace_power_off,       // payload: power domain bits
+  trace_sleep,           // payload: sensor count
+  trace_wake,            // payload: 1 when woken by the user
+  trace_measure,         // payload: sensor count
+  trace_filesystem_open,
+  trace_filesystem_close,
+  trace_battery_tier,    // payload: battery_tier_type
+  trace_low_memory,      // payload: free bytes
+  trace_event_count
+} trace_event_type;
+
+typedef enum trace_reset
+{
+  trace_reset_power_on,
+  trace_reset_pin,
+  trace_reset_watchdog,
+  trace_reset_window_watchdog,
+  trace_reset_low_power,
+  trace_reset_software,    // requested without a reason
+  trace_reset_low_memory,
+  trace_reset_sd_failure,
+  trace_reset_command
+} trace_reset_type;
+
+typedef struct trace_entry
+{
+  uint32 milliseconds;
+  uint16 event;
+  uint16 payload;
+} trace_entry_type;
+
+typedef struct trace_ring
+{
+  uint32 magic;
+  uint32 next; // free running, the entry written is next % TRACE_ENTRY_COUNT
+  uint32 requestedReset; // trace_reset_type for the software reset in progress
+  trace_entry_type entries[TRACE_ENTRY_COUNT];
+} trace_ring_type;
+
+extern trace_ring_type traceRing;
+
+// Reads the reset cause before startWatchdog() clears the flags and starts the ring if it was lost.
+void startTrace();
+
+// Prints the events leading up to the last reset, and writes them to the data file when one is given.
+void reportTrace(WaterBear_FileSystem * fileSystem);
+
+// Records the reason and resets, the reason is reported on the next boot.
+void resetWithReason(trace_reset_type reason);
+
+// Interrupts can record too, at worst an entry overwritten by an interrupt is lost.
+inline void trace(trace_event_type event, uint16 payload = 0)
+{
+  trace_entry_type &entry = traceRing.entries[traceRing.next++ % TRACE_ENTRY_COUNT];
+  entry.milliseconds = millis();
+  entry.event = event;
+  entry.payload = payload;
+}
+
+#endif
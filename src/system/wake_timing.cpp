@@ -0,0 +1,72 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "wake_timing.h"
+#include "clock.h"
+#include "logs.h"
+
+void WakeTiming::begin(uint32 alarmTicks)
+{
+  this->alarmTicks = alarmTicks;
+  memset(phaseMarked, 0, sizeof(phaseMarked));
+  active = true;
+}
+
+void WakeTiming::mark(wake_phase_type phase)
+{
+  mark(phase, internalRTCTicks());
+}
+
+void WakeTiming::mark(wake_phase_type phase, uint32 ticks)
+{
+  if (!active)
+  {
+    return;
+  }
+  phaseTicks[phase] = ticks;
+  phaseMarked[phase] = true;
+}
+
+bool WakeTiming::inProgress()
+{
+  return active;
+}
+
+bool WakeTiming::report(char * record, size_t length)
+{
+  if (!active)
+  {
+    return false;
+  }
+  active = false;
+
+  // each phase as the time since the previous one, skipped phases as 0
+  record[0] = '\0';
+  uint32 previous = alarmTicks;
+  for (unsigned short i = 0; i < WAKE_PHASE_COUNT; i++)
+  {
+    uint32 spent = 0;
+    if (phaseMarked[i])
+    {
+      spent = (phaseTicks[i] - previous) * 1000 / INTERNAL_RTC_TICKS_PER_SECOND;
+      previous = phaseTicks[i];
+    }
+    size_t used = strlen(record);
+    snprintf(&record[used], length - used, i == 0 ? "%lu" : ",%lu", spent);
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_WAKE_TIMING
+#define WATERBEAR_WAKE_TIMING
+
+#include <Arduino.h>
+
+// Phases of the wake path, in the order they complete
+typedef enum wake_phase
+{
+  wake_phase_resumed,           // out of stop mode, clocks relocked
+  wake_phase_restored,          // serial, pins and watchdog back
+  wake_phase_powered,           // power domains for this wake settled
+  wake_phase_clock_checked,     // DS3231 read
+  wake_phase_sensors_started,   // due sensors set up
+  wake_phase_filesystem_opened, // SD card mounted, skipped while writes are batched
+  wake_phase_first_sample,      // first sample of the wake collected
+  WAKE_PHASE_COUNT
+} wake_phase_type;
+
+#define WAKE_TIMING_RECORD_LENGTH 80
+
+// Internal RTC timestamps for each phase of a wake, from the alarm to the first sample.
+// Reported as the milliseconds spent in each phase, e.g.
+// 3,1,502,4,35,120,640
+class WakeTiming
+{
+public:
+  void begin(uint32 alarmTicks);
+  void mark(wake_phase_type phase);
+  void mark(wake_phase_type phase, uint32 ticks);
+  bool inProgress();
+  bool report(char * record, size_t length); // formats the record and ends the wake, false if no wake was timed
+
+private:
+  bool active = false;
+  uint32 alarmTicks;
+  uint32 phaseTicks[WAKE_PHASE_COUNT];
+  bool phaseMarked[WAKE_PHASE_COUNT];
+};
+
+#endif
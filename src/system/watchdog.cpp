@@ -15,96 +15,87 @@
  *  You should have received a copy of the GNU General Public License
  *  along with this program.  If not, see <http://www.gnu.org/licenses/>
  */
-
 #include "watchdog.h"
 #include <Arduino.h>
 #include <libmaple/libmaple.h>
+#include <libmaple/rcc.h>
 #include "logs.h"
+#include "low_power.h"
+#include "trace.h"
 
-void timerFired() // trigger a reset
-{
-  // Can only output 2 chars because interrupts can't handle more
-  timer_pause(TIMER1);
-  Serial2.println("TF");
+#define WATCHDOG_KEY_UNLOCK 0x5555 // allows writes to the prescaler and reload registers
+#define WATCHDOG_SR_RVU (1 << 1)   // reload value update in progress
 
-  //notify("TF"); // calls flush leading to a crash as well
-  //Serial2.flush(); // causes crash
-  delay(5000);
-  nvic_sys_reset();
-}
+static watchdog_phase_type currentPhase = watchdog_boot;
 
-void reloadCustomWatchdog()
+static void waitForReloadUpdate()
 {
-  debug(F("reloadCustomWatchdog"));
-  timer_generate_update(TIMER1);
+  // takes up to 5 LSI periods after the prescaler, ~32ms
+  while (IWDG_BASE->SR & WATCHDOG_SR_RVU)
+  {
+    enterIdleMode();
+  }
 }
 
-
-/*
-void extendCustomWatchdog(int seconds)
+static unsigned short phaseSeconds(watchdog_phase_type phase)
 {
-  while (seconds > 0)
+  switch (phase)
   {
-    debug(seconds);
-    reloadCustomWatchdog();
-    if (seconds > DEFAULT_WATCHDOG_TIMEOUT_SECONDS - 1)
-    {
-      delay((DEFAULT_WATCHDOG_TIMEOUT_SECONDS-1)*1000);
-    }
-    else
-    {
-      delay(seconds * 1000);
-    }
-    seconds = seconds - (DEFAULT_WATCHDOG_TIMEOUT_SECONDS - 1);
+  case watchdog_measurement:
+    return WATCHDOG_MEASUREMENT_SECONDS;
+  case watchdog_sd:
+    return WATCHDOG_SD_SECONDS;
+  case watchdog_cli:
+    return WATCHDOG_CLI_SECONDS;
+  case watchdog_sleep:
+    return WATCHDOG_SLEEP_SECONDS;
+  case watchdog_boot:
+  default:
+    return WATCHDOG_BOOT_SECONDS;
   }
-}*/
+}
 
-void startCustomWatchDog()
+static uint16 phaseReload(watchdog_phase_type phase)
 {
-  startCustomWatchDog(DEFAULT_WATCHDOG_TIMEOUT_SECONDS);
+  unsigned long reload = (unsigned long) phaseSeconds(phase) * WATCHDOG_COUNTS_PER_SECOND;
+  return reload > WATCHDOG_MAX_RELOAD ? WATCHDOG_MAX_RELOAD : reload;
 }
 
-void startCustomWatchDog(int watchdogSeconds)
+void startWatchdog()
 {
-  debug("Setup watchdog");
-
-  timer_init(TIMER1);
-  timer_set_prescaler(TIMER1, 65535); //  64000000 / 65536 = 976.5 Hz
-  // int watchdogValue = 5 * 976.5 ; // 976.5 Hz * ( 5 * 976.5 counts) = 5s
-  int watchdogValue = watchdogSeconds * 976.5; // 976.5 Hz * ( 5 * 976.5 counts) = 5s
-  timer_set_compare(TIMER1, TIMER_CH1, watchdogValue);
-  // timer_cc_enable(TIMER1, TIMER_CH1); // not necessary?
-
-  timer_set_reload(TIMER1, watchdogValue);
-  timer_generate_update(TIMER1);
-
-  timer_resume(TIMER1);
-  // debug(F("Resumed timer"));
+  if (RCC_BASE->CSR & RCC_CSR_IWDGRSTF)
+  {
+    notify(F("Reset by watchdog"));
+  }
+  RCC_BASE->CSR |= RCC_CSR_RMVF; // clear the reset flags for next time
 
-  timer_attach_interrupt(TIMER1, TIMER_CC1_INTERRUPT, timerFired);
-  // debug(F("Attached interrupt!"));
+  currentPhase = watchdog_boot;
+  iwdg_init(IWDG_PRE_256, phaseReload(currentPhase));
 }
 
-void disableCustomWatchDog()
+watchdog_phase_type setWatchdogPhase(watchdog_phase_type phase)
 {
-  timer_detach_interrupt(TIMER1, TIMER_CC1_INTERRUPT);
-  // timer_pause(TIMER1);
-  // timer_cc_disable(TIMER1, TIMER_CH1);
-  // timer_generate_update(TIMER1);
-  // timer_disable(TIMER1);
-
-  //timer_disable_irq ??
-  // nvic_irq_disable()
-
-  rcc_reset_dev(TIMER1->clk_id);
-  rcc_clk_disable(TIMER1->clk_id);
-
-  // timer_init(TIMER1); // not necessary
+  watchdog_phase_type previous = currentPhase;
+  if (phase != currentPhase)
+  {
+    waitForReloadUpdate();
+    IWDG_BASE->KR = WATCHDOG_KEY_UNLOCK;
+    IWDG_BASE->RLR = phaseReload(phase);
+    if (phaseSeconds(phase) > phaseSeconds(currentPhase))
+    {
+      // a feed before the update lands would reload the shorter timeout
+      // shortening can take effect at any later feed
+      waitForReloadUpdate();
+    }
+    currentPhase = phase;
+    trace(trace_watchdog_phase, phase);
+  }
+  feedWatchdog();
+  return previous;
 }
 
-void printWatchDogStatus(){
-  char message[50];
-  int timerCount = timer_get_count(TIMER1);
-  sprintf(message, reinterpret_cast<const char *> F("Timer Count: %d"), timerCount);
-  debug(timerCount);
+unsigned long watchdogFeedIntervalMilliseconds()
+{
+  // half the nominal timeout stays clear of the 60kHz worst case
+  return (unsigned long) phaseSeconds(currentPhase) * 500;
 }
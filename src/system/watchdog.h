@@ -19,21 +19,42 @@
 #ifndef WATERBEAR_WATCHDOG
 #define WATERBEAR_WATCHDOG
 
-#define DEFAULT_WATCHDOG_TIMEOUT_SECONDS 20
-#define MAX_WATCHDOG_TIMEOUT_SECONDS 65
-
-void timerFired();
-
-void reloadCustomWatchdog();
-
-//void extendCustomWatchdog(int seconds);
-
-void startCustomWatchDog();
-
-void startCustomWatchDog(int watchdogSeconds);
-
-void disableCustomWatchDog();
-
-void printWatchDogStatus();
-
-#endif
\ No newline at end of file
+#include <libmaple/iwdg.h>
+
+// Independent watchdog, clocked by the LSI so it keeps counting through stop mode.
+// Once started it can't be stopped, long sleeps wake on the internal RTC alarm to feed it.
+#define WATCHDOG_LSI_HZ 40000 // nominal, the LSI runs anywhere from 30kHz to 60kHz
+#define WATCHDOG_COUNTS_PER_SECOND (WATCHDOG_LSI_HZ / 256) // prescaler 256
+#define WATCHDOG_MAX_RELOAD 4095 // 26s at the nominal LSI
+
+// Timeout for each phase, at the nominal LSI, reaches reset in 2/3 of this with a fast LSI
+#define WATCHDOG_BOOT_SECONDS 26
+#define WATCHDOG_MEASUREMENT_SECONDS 16
+#define WATCHDOG_SD_SECONDS 12
+#define WATCHDOG_CLI_SECONDS 16
+#define WATCHDOG_SLEEP_SECONDS 26
+
+typedef enum watchdog_phase
+{
+  watchdog_boot,
+  watchdog_measurement,
+  watchdog_sd,
+  watchdog_cli,
+  watchdog_sleep
+} watchdog_phase_type;
+
+void startWatchdog(); // boot phase, reports a previous watchdog reset
+
+// Changes the timeout and feeds, returns the phase it replaces so it can be restored.
+// Cheap when the phase doesn't change.
+watchdog_phase_type setWatchdogPhase(watchdog_phase_type phase);
+
+// Longest wait between feeds that is safe in the current phase with the fastest LSI
+unsigned long watchdogFeedIntervalMilliseconds();
+
+inline void feedWatchdog()
+{
+  IWDG_BASE->KR = 0xAAAA; // reload the counter
+}
+
+#endif
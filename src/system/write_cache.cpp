@@ -20,6 +20,7 @@
 #include "string.h"
 #include "Arduino.h"
 #include "monitor.h"
+#include "serial_tx.h"
 
 WriteCache::WriteCache(OutputDevice * outputDevice)
 {
@@ -52,16 +53,25 @@ void WriteCache::endOfLine()
 void WriteCache::flushCache()
 {
   // notify("flushing cache");
+  if(flushHandler != NULL)
+  {
+    flushHandler(flushHandlerContext);
+  }
   char hello[100] = "\0";
   outputDevice->writeString(hello); // why is this required??
   outputDevice->writeString(cache);
   if(outputToSerial)
   {
-    Serial2.print(cache);
+    SerialOutput.print(cache);
   }
   initCache();
 }
 
+unsigned int WriteCache::available()
+{
+  return cacheSize - 1 - nextPosition;
+}
+
 void WriteCache::initCache()
 {
   memset( cache, 0, MAX_CACHE_SIZE );
@@ -72,3 +82,9 @@ void WriteCache::setOutputToSerial(bool value)
 {
   outputToSerial = value;
 }
+
+void WriteCache::setFlushHandler(flush_handler handler, void * context)
+{
+  flushHandler = handler;
+  flushHandlerContext = context;
+}
@@ -19,6 +19,9 @@
 #ifndef WATERBEAR_WRITE_CACHE
 #define WATERBEAR_WRITE_CACHE
 
+#include <Arduino.h>
+#include "memory.h"
+
 #define MAX_CACHE_SIZE 1000
 
 class OutputDevice
@@ -29,16 +32,24 @@ class OutputDevice
 
 };
 
+// called before the cache is written out, e.g. to mount an SD card that was left off
+typedef void (*flush_handler)(void * context);
+
 class WriteCache 
 {
 
   public:
+  static void * operator new(size_t size) { return taggedMalloc(memory_filesystem, size); }
+  static void operator delete(void * pointer) { taggedFree(memory_filesystem, pointer); }
+
   // methods
   WriteCache(OutputDevice * outputDevice);
   void writeString(const char * string);
   void endOfLine();
   void flushCache();
+  unsigned int available(); // bytes that can be written before the cache flushes
   void setOutputToSerial(bool);
+  void setFlushHandler(flush_handler handler, void * context);
 
   // variables
   unsigned int cacheSize = MAX_CACHE_SIZE; // must be MAX_CACHE_SIZE or less
@@ -53,6 +64,8 @@ class WriteCache
   unsigned int nextPosition = 0;
 
   bool outputToSerial = false;
+  flush_handler flushHandler = NULL;
+  void * flushHandlerContext = NULL;
 
 };
 
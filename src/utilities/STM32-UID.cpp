@@ -18,6 +18,7 @@
 
 #include "STM32-UID.h"
 #include "Arduino.h"
+#include "system/serial_tx.h"
 
 /*
 void foobar()
@@ -49,6 +50,6 @@ void decodeUniqueId(unsigned char * uuid, char * uuidString, int uuidLength)
   {
     sprintf(&uuidString[2 * i], "%02X", (byte)uuid[i]);
   }
-  Serial2.println(uuidString);
-  Serial2.flush();
+  SerialOutput.println(uuidString);
+  SerialOutput.flush();
 }
\ No newline at end of file
@@ -0,0 +1,67 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "cobs.h"
+
+void cobsWrite(Print &output, const byte * data, size_t length)
+{
+  size_t start = 0;
+  while(true)
+  {
+    size_t run = 0;
+    while(start + run < length && run < 254 && data[start + run] != 0)
+    {
+      run++;
+    }
+    output.write((uint8) (run + 1));
+    output.write(data + start, run);
+    start += run;
+    if(start >= length)
+    {
+      break;
+    }
+    if(run < 254)
+    {
+      start++; // the zero this block's code stands for
+    }
+  }
+}
+
+int cobsDecode(byte * data, size_t length)
+{
+  // the output never overtakes the input, each block loses its code byte and gains at most one zero
+  size_t read = 0;
+  size_t written = 0;
+  while(read < length)
+  {
+    byte code = data[read++];
+    if(code == 0 || read + code - 1 > length)
+    {
+      return -1;
+    }
+    for(byte i = 1; i < code; i++)
+    {
+      data[written++] = data[read++];
+    }
+    if(code != 0xFF && read < length)
+    {
+      data[written++] = 0;
+    }
+  }
+  return written;
+}
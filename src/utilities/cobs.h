@@ -0,0 +1,35 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_COBS
+#define WATERBEAR_COBS
+
+#include <Arduino.h>
+
+// Consistent Overhead Byte Stuffing, removes every zero so that 0x00 can delimit frames.
+// Each block is a code byte n followed by n - 1 non zero bytes, then an implied zero unless n is 0xFF
+// or the block is the last.  Encoding adds at most one byte in 254.
+#define COBS_ENCODED_LENGTH(length) ((length) + (length) / 254 + 1)
+
+// encodes straight to the output, without a delimiter
+void cobsWrite(Print &output, const byte * data, size_t length);
+
+// decodes in place, returns the decoded length or -1 if the data is not valid COBS
+int cobsDecode(byte * data, size_t length);
+
+#endif
@@ -0,0 +1,40 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#include "crc.h"
+
+unsigned short crc16(const void * data, unsigned int length, unsigned short crc)
+{
+  const byte * bytes = (const byte *) data;
+  for(unsigned int i = 0; i < length; i++)
+  {
+    crc ^= (unsigned short) bytes[i] << 8;
+    for(byte bit = 0; bit < 8; bit++)
+    {
+      if(crc & 0x8000)
+      {
+        crc = (crc << 1) ^ 0x1021;
+      }
+      else
+      {
+        crc = crc << 1;
+      }
+    }
+  }
+  return crc;
+}
@@ -0,0 +1,29 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+
+#ifndef WATERBEAR_CRC
+#define WATERBEAR_CRC
+
+#include <Arduino.h>
+
+#define CRC16_INITIAL_VALUE 0xFFFF
+
+// CRC-16/CCITT-FALSE, pass a previous result as crc to continue over multiple buffers
+unsigned short crc16(const void * data, unsigned int length, unsigned short crc = CRC16_INITIAL_VALUE);
+
+#endif
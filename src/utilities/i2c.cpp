@@ -140,6 +140,13 @@ void enableI2C1()
   scanIC2(&Wire);
 }
 
+void resumeI2C1()
+{
+  i2c_disable(I2C1);
+  i2c_master_enable(I2C1, 0, 0);
+  WireOne.begin();
+}
+
 void enableI2C2()
 {
   i2c_disable(I2C2);
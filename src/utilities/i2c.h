@@ -24,5 +24,6 @@ void i2cError(int transmissionCode);
 void scanIC2(TwoWire *wire);
 bool scanIC2(TwoWire *wire, int searchAddress);
 void enableI2C1();
+void resumeI2C1(); // enableI2C1() without the settle delay and bus scan, for waking from sleep
 void enableI2C2();
 
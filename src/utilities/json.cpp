@@ -0,0 +1,504 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#include "json.h"
+#include <limits.h>
+
+#define JSON_MAX_DEPTH 8 // nested values skipped over while looking up members
+
+static const char * skipWhitespace(const char * p)
+{
+  while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+  {
+    p++;
+  }
+  return p;
+}
+
+// p at the opening quote, returns just past the closing quote or NULL
+static const char * skipString(const char * p)
+{
+  p++;
+  while (*p != '"')
+  {
+    if (*p == '\0' || (unsigned char) *p < 0x20)
+    {
+      return NULL;
+    }
+    if (*p == '\\')
+    {
+      p++;
+      if (*p == '\0')
+      {
+        return NULL;
+      }
+    }
+    p++;
+  }
+  return p + 1;
+}
+
+static const char * skipDigits(const char * p)
+{
+  while (*p >= '0' && *p <= '9')
+  {
+    p++;
+  }
+  return p;
+}
+
+static const char * skipNumber(const char * p)
+{
+  if (*p == '-')
+  {
+    p++;
+  }
+  if (*p < '0' || *p > '9')
+  {
+    return NULL;
+  }
+  p = skipDigits(p);
+  if (*p == '.')
+  {
+    p++;
+    if (*p < '0' || *p > '9')
+    {
+      return NULL;
+    }
+    p = skipDigits(p);
+  }
+  if (*p == 'e' || *p == 'E')
+  {
+    p++;
+    if (*p == '+' || *p == '-')
+    {
+      p++;
+    }
+    if (*p < '0' || *p > '9')
+    {
+      return NULL;
+    }
+    p = skipDigits(p);
+  }
+  return p;
+}
+
+static const char * skipLiteral(const char * p, const char * literal)
+{
+  size_t length = strlen(literal);
+  return strncmp(p, literal, length) == 0 ? p + length : NULL;
+}
+
+static const char * skipValue(const char * p, unsigned short depth);
+
+// p at the opening bracket, members are "key": value for objects and just values for arrays
+static const char * skipContainer(const char * p, char close, bool keyed, unsigned short depth)
+{
+  if (depth >= JSON_MAX_DEPTH)
+  {
+    return NULL;
+  }
+  p = skipWhitespace(p + 1);
+  if (*p == close)
+  {
+    return p + 1;
+  }
+  while (p != NULL)
+  {
+    if (keyed)
+    {
+      if (*p != '"' || (p = skipString(p)) == NULL)
+      {
+        return NULL;
+      }
+      p = skipWhitespace(p);
+      if (*p != ':')
+      {
+        return NULL;
+      }
+      p = skipWhitespace(p + 1);
+    }
+    p = skipValue(p, depth + 1);
+    if (p == NULL)
+    {
+      return NULL;
+    }
+    p = skipWhitespace(p);
+    if (*p == close)
+    {
+      return p + 1;
+    }
+    if (*p != ',')
+    {
+      return NULL;
+    }
+    p = skipWhitespace(p + 1);
+  }
+  return NULL;
+}
+
+static const char * skipValue(const char * p, unsigned short depth)
+{
+  switch (*p)
+  {
+  case '"':
+    return skipString(p);
+  case '{':
+    return skipContainer(p, '}', true, depth);
+  case '[':
+    return skipContainer(p, ']', false, depth);
+  case 't':
+    return skipLiteral(p, "true");
+  case 'f':
+    return skipLiteral(p, "false");
+  case 'n':
+    return skipLiteral(p, "null");
+  default:
+    return skipNumber(p);
+  }
+}
+
+static json_type typeAt(const char * p)
+{
+  switch (*p)
+  {
+  case '"':
+    return json_string;
+  case '{':
+    return json_object;
+  case '[':
+    return json_array;
+  case 't':
+    return json_true;
+  case 'f':
+    return json_false;
+  case 'n':
+    return json_null;
+  default:
+    return json_number;
+  }
+}
+
+static unsigned short hexValue(char c)
+{
+  if (c >= '0' && c <= '9')
+  {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f')
+  {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F')
+  {
+    return c - 'A' + 10;
+  }
+  return 0;
+}
+
+// p at the opening quote of a validated string, writes at most length - 1 characters
+// returns the unescaped length, which is over length - 1 when it didn't fit
+static size_t unescapeString(const char * p, char * output, size_t length)
+{
+  size_t count = 0;
+  for (p++; *p != '"'; p++)
+  {
+    char c = *p;
+    if (c == '\\')
+    {
+      p++;
+      switch (*p)
+      {
+      case 'b': c = '\b'; break;
+      case 'f': c = '\f'; break;
+      case 'n': c = '\n'; break;
+      case 'r': c = '\r'; break;
+      case 't': c = '\t'; break;
+      case 'u':
+      {
+        unsigned short code = 0;
+        for (unsigned short i = 0; i < 4 && p[1] != '"'; i++)
+        {
+          code = (code << 4) | hexValue(*++p);
+        }
+        c = code < 0x80 ? (char) code : '?'; // configuration strings are ASCII
+        break;
+      }
+      default: c = *p; break; // \" \\ \/
+      }
+    }
+    if (count + 1 < length)
+    {
+      output[count] = c;
+    }
+    count++;
+  }
+  if (length > 0)
+  {
+    output[count + 1 < length ? count : length - 1] = '\0';
+  }
+  return count;
+}
+
+static double parseNumber(const char * p)
+{
+  bool negative = *p == '-';
+  if (negative)
+  {
+    p++;
+  }
+  double value = 0;
+  while (*p >= '0' && *p <= '9')
+  {
+    value = value * 10 + (*p++ - '0');
+  }
+  if (*p == '.')
+  {
+    double scale = 0.1;
+    for (p++; *p >= '0' && *p <= '9'; p++)
+    {
+      value += (*p - '0') * scale;
+      scale /= 10;
+    }
+  }
+  if (*p == 'e' || *p == 'E')
+  {
+    p++;
+    bool negativeExponent = *p == '-';
+    if (*p == '+' || *p == '-')
+    {
+      p++;
+    }
+    int exponent = 0;
+    while (*p >= '0' && *p <= '9' && exponent < 400)
+    {
+      exponent = exponent * 10 + (*p++ - '0');
+    }
+    while (exponent-- > 0)
+    {
+      value = negativeExponent ? value / 10 : value * 10;
+    }
+  }
+  return negative ? -value : value;
+}
+
+JSONReader::JSONReader(const char * json) : json(json)
+{
+  const char * p = skipWhitespace(json);
+  isValid = false;
+  if (*p == '{')
+  {
+    p = skipValue(p, 0);
+    isValid = p != NULL && *skipWhitespace(p) == '\0';
+  }
+}
+
+bool JSONReader::valid()
+{
+  return isValid;
+}
+
+const char * JSONReader::findValue(const char * key)
+{
+  if (!isValid)
+  {
+    return NULL;
+  }
+  size_t keyLength = strlen(key);
+  const char * p = skipWhitespace(skipWhitespace(json) + 1);
+  while (*p == '"')
+  {
+    // keys are compared as written, escapes included
+    const char * keyEnd = skipString(p) - 1;
+    bool match = (size_t) (keyEnd - p - 1) == keyLength && strncmp(p + 1, key, keyLength) == 0;
+    p = skipWhitespace(skipWhitespace(keyEnd + 1) + 1); // past the colon
+    if (match)
+    {
+      return p;
+    }
+    p = skipWhitespace(skipValue(p, 1));
+    if (*p != ',')
+    {
+      break;
+    }
+    p = skipWhitespace(p + 1);
+  }
+  return NULL;
+}
+
+json_type JSONReader::typeOf(const char * key)
+{
+  const char * value = findValue(key);
+  return value == NULL ? json_missing : typeAt(value);
+}
+
+bool JSONReader::has(const char * key)
+{
+  return findValue(key) != NULL;
+}
+
+bool JSONReader::getString(const char * key, char * value, size_t length)
+{
+  const char * p = findValue(key);
+  if (p == NULL || typeAt(p) != json_string || unescapeString(p, NULL, 0) + 1 > length)
+  {
+    return false;
+  }
+  unescapeString(p, value, length);
+  return true;
+}
+
+bool JSONReader::getNumber(const char * key, double * value)
+{
+  const char * p = findValue(key);
+  if (p == NULL || typeAt(p) != json_number)
+  {
+    return false;
+  }
+  *value = parseNumber(p);
+  return true;
+}
+
+bool JSONReader::getInteger(const char * key, long * value)
+{
+  double number;
+  if (!getNumber(key, &number))
+  {
+    return false;
+  }
+  // saturate like cJSON's valueint, the cast alone is undefined out of range
+  if (number >= (double) LONG_MAX)
+  {
+    *value = LONG_MAX;
+  }
+  else if (number <= (double) LONG_MIN)
+  {
+    *value = LONG_MIN;
+  }
+  else
+  {
+    *value = (long) number;
+  }
+  return true;
+}
+
+JSONWriter::JSONWriter(char * buffer, size_t length) : buffer(buffer), length(length)
+{
+  if (length > 0)
+  {
+    buffer[0] = '\0';
+  }
+  append("{");
+}
+
+void JSONWriter::append(const char * text)
+{
+  while (*text != '\0')
+  {
+    if (position + 1 >= length)
+    {
+      overflowed = true;
+      return;
+    }
+    buffer[position++] = *text++;
+  }
+  buffer[position] = '\0';
+}
+
+void JSONWriter::appendEscaped(const char * text)
+{
+  char escaped[7];
+  append("\"");
+  for (; *text != '\0'; text++)
+  {
+    switch (*text)
+    {
+    case '"': append("\\\""); break;
+    case '\\': append("\\\\"); break;
+    case '\n': append("\\n"); break;
+    case '\r': append("\\r"); break;
+    case '\t': append("\\t"); break;
+    default:
+      if ((unsigned char) *text < 0x20)
+      {
+        snprintf(escaped, sizeof(escaped), "\\u%04x", *text);
+      }
+      else
+      {
+        escaped[0] = *text;
+        escaped[1] = '\0';
+      }
+      append(escaped);
+    }
+  }
+  append("\"");
+}
+
+void JSONWriter::beginMember(const char * key)
+{
+  append(members++ > 0 ? ",\n\t" : "\n\t");
+  appendEscaped(key);
+  append(":\t");
+}
+
+void JSONWriter::addString(const char * key, const char * value)
+{
+  beginMember(key);
+  appendEscaped(value);
+}
+
+void JSONWriter::addInteger(const char * key, long long value)
+{
+  char number[24];
+  snprintf(number, sizeof(number), "%lld", value);
+  beginMember(key);
+  append(number);
+}
+
+void JSONWriter::addNumber(const char * key, double value)
+{
+  char number[32];
+  if (value > -2147483648.0 && value < 2147483647.0 && value == (long) value)
+  {
+    snprintf(number, sizeof(number), "%ld", (long) value);
+  }
+  else
+  {
+    snprintf(number, sizeof(number), "%1.15g", value);
+  }
+  beginMember(key);
+  append(number);
+}
+
+void JSONWriter::addIntegerArray(const char * key, const int * values, unsigned short count)
+{
+  char number[14];
+  beginMember(key);
+  append("[");
+  for (unsigned short i = 0; i < count; i++)
+  {
+    snprintf(number, sizeof(number), i > 0 ? ", %d" : "%d", values[i]);
+    append(number);
+  }
+  append("]");
+}
+
+bool JSONWriter::finish()
+{
+  append(members > 0 ? "\n}" : "}");
+  return !overflowed;
+}
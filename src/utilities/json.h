@@ -0,0 +1,91 @@
+/* 
+ *  RRIV - Open Source Environmental Data Logging Platform
+ *  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+ *  
+ *  This program is free software: you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation, either version 3 of the License, or
+ *  (at your option) any later version.
+ *  
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *  
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program.  If not, see <http://www.gnu.org/licenses/>
+ */
+#ifndef WATERBEAR_JSON
+#define WATERBEAR_JSON
+
+#include <Arduino.h>
+#include <stddef.h>
+
+// JSON for the configuration commands without the heap.
+// JSONReader looks members up in a flat object in place in the command line,
+// JSONWriter formats an object straight into a caller's buffer.
+
+typedef enum json_type
+{
+  json_missing,
+  json_string,
+  json_number,
+  json_true,
+  json_false,
+  json_null,
+  json_object,
+  json_array
+} json_type;
+
+class JSONReader
+{
+public:
+  // json is not copied and must outlive the reader
+  JSONReader(const char * json);
+
+  // a single well formed object, checked once by the constructor
+  bool valid();
+
+  json_type typeOf(const char * key);
+  bool has(const char * key);
+
+  // false, leaving value untouched, when the member is missing or of another type
+  // strings also fail when longer than length - 1
+  bool getString(const char * key, char * value, size_t length);
+  bool getInteger(const char * key, long * value); // numbers with a fraction are truncated
+  bool getNumber(const char * key, double * value);
+
+private:
+  const char * json;
+  bool isValid;
+
+  const char * findValue(const char * key);
+};
+
+class JSONWriter
+{
+public:
+  // formats like cJSON_Print, a member per line, into buffer
+  JSONWriter(char * buffer, size_t length);
+
+  void addString(const char * key, const char * value);
+  void addInteger(const char * key, long long value);
+  void addNumber(const char * key, double value);
+  void addIntegerArray(const char * key, const int * values, unsigned short count);
+
+  // closes the object, returns false when the buffer was too small and the output is cut short
+  bool finish();
+
+private:
+  char * buffer;
+  size_t length;
+  size_t position = 0;
+  unsigned short members = 0;
+  bool overflowed = false;
+
+  void append(const char * text);
+  void appendEscaped(const char * text);
+  void beginMember(const char * key);
+};
+
+#endif
@@ -20,15 +20,13 @@
 #include <Arduino.h>
 #include <libmaple/libmaple.h>
 #include "system/logs.h"
+#include "system/trace.h"
 #include "utilities/utilities.h"
 
 extern "C" char* _sbrk(int incr);
 int freeMemory()
 {
   char top;
-  debug((int) &top );
-  debug((int) reinterpret_cast<char*>(_sbrk(0)) );
-
   return &top - reinterpret_cast<char*>(_sbrk(0));
 }
 
@@ -44,13 +42,12 @@ void checkMemory()
 {
   // calculate and print free memory
   // reset the system if we are running out of memory
-  char freeMemoryMessage[21];
   int freeMemoryAmount = freeMemory();
-  sprintf(freeMemoryMessage, reinterpretCharPtr(F("Free Memory: %d")), freeMemoryAmount);
-  debug(freeMemoryMessage);
+  LOG_DEBUGF("Free Memory: %d", freeMemoryAmount);
   if(freeMemoryAmount < 500){
     debug(F("Low mem, resetting!"));
-    nvic_sys_reset(); // software reset, takes us back to init
+    trace(trace_low_memory, freeMemoryAmount);
+    resetWithReason(trace_reset_low_memory); // software reset, takes us back to init
   }
 }
 
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+#
+#  RRIV - Open Source Environmental Data Logging Platform
+#  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+"""Expand the binary debug records sent after the 'trace-binary' command.
+
+Text lines pass through unchanged. Each record carries the flash address of its
+printf format string, which is looked up in the firmware ELF, see src/system/logs.h.
+
+  python3 tools/log_decoder.py .pio/build/NUCLEO-F103RB/firmware.elf /dev/ttyACM0
+  python3 tools/log_decoder.py firmware.elf captured.bin
+"""
+
+import re
+import struct
+import sys
+
+RECORD_START = 0x1E
+HEADER_LENGTH = 6
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+SPECIFIER = re.compile(r"%([-+ #0-9.]*)(l*|h*)([a-zA-Z%])")
+
+
+class Firmware:
+    """Reads strings by address from the allocated sections of a 32 bit little endian ELF."""
+
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.image = f.read()
+        shoff, = struct.unpack_from("<I", self.image, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", self.image, 0x2E)
+        self.sections = []
+        for i in range(shnum):
+            _, kind, flags, address, offset, size = struct.unpack_from("<IIIIII", self.image, shoff + i * shentsize)
+            if flags & SHF_ALLOC and kind != SHT_NOBITS and size > 0:
+                self.sections.append((address, offset, size))
+
+    def string(self, address):
+        for start, offset, size in self.sections:
+            if start <= address < start + size:
+                position = offset + address - start
+                end = self.image.index(b"\0", position)
+                return self.image[position:end].decode("ascii", "replace")
+        return None
+
+
+def expand(firmware, address, payload):
+    fmt = firmware.string(address)
+    if fmt is None:
+        return "<unknown record 0x%08x %s>" % (address, payload.hex())
+
+    position = 0
+    pieces = []
+    last = 0
+    for match in SPECIFIER.finditer(fmt):
+        pieces.append(fmt[last:match.start()])
+        last = match.end()
+        flags, length, conversion = match.groups()
+        if conversion == "%":
+            pieces.append("%")
+            continue
+        spec = "%" + flags + conversion
+        if conversion in "feg":
+            value, = struct.unpack_from("<d", payload, position)
+            position += 8
+        elif conversion == "s":
+            count = payload[position]
+            value = payload[position + 1:position + 1 + count].decode("ascii", "replace")
+            position += 1 + count
+        elif len(length) >= 2:
+            value, = struct.unpack_from("<q" if conversion in "di" else "<Q", payload, position)
+            position += 8
+        else:
+            value, = struct.unpack_from("<i" if conversion in "di" else "<I", payload, position)
+            position += 4
+            if conversion == "c":
+                value = chr(value & 0xFF)
+        pieces.append(spec % value)
+    pieces.append(fmt[last:])
+    return "".join(pieces)
+
+
+def decode(firmware, stream, out):
+    line = bytearray()
+    while True:
+        byte = stream.read(1)
+        if not byte:
+            break
+        if byte[0] == RECORD_START:
+            header = stream.read(HEADER_LENGTH - 1)
+            if len(header) < HEADER_LENGTH - 1:
+                break
+            address, length = struct.unpack("<IB", header)
+            payload = stream.read(length)
+            try:
+                out.write(expand(firmware, address, payload) + "\n")
+            except (struct.error, IndexError, TypeError, ValueError):
+                out.write("<truncated record 0x%08x>\n" % address)
+            out.flush()
+        elif byte == b"\n":
+            out.write(line.decode("ascii", "replace") + "\n")
+            out.flush()
+            line = bytearray()
+        elif byte != b"\r":
+            line += byte
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    firmware = Firmware(sys.argv[1])
+    with open(sys.argv[2], "rb", buffering=0) as stream:
+        decode(firmware, stream, sys.stdout)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,310 @@
+#!/usr/bin/env python3
+#
+#  RRIV - Open Source Environmental Data Logging Platform
+#  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+"""Talk to a logger over the binary command protocol, see src/system/binary_protocol.h.
+
+  python3 tools/rriv_protocol.py /dev/ttyACM0 info
+  python3 tools/rriv_protocol.py /dev/ttyACM0 get-config
+  python3 tools/rriv_protocol.py /dev/ttyACM0 set-config deployment.jsonl
+  python3 tools/rriv_protocol.py /dev/ttyACM0 values
+  python3 tools/rriv_protocol.py /dev/ttyACM0 ls [PATH]
+  python3 tools/rriv_protocol.py /dev/ttyACM0 export PATH DESTINATION
+
+set-config takes one JSON object per line, objects with a "slot" go to set-slot-config.
+The logger must be awake in interactive mode, as for the text CLI.
+"""
+
+import json
+import os
+import select
+import struct
+import sys
+import termios
+import time
+
+SYNC = 0x00
+RESPONSE = 0x80
+EVENT = 0x40
+MAX_BODY = 512
+PIPELINE_BYTES = 64
+TIMEOUT = 2.0
+RETRIES = 3
+
+INFO = 0x01
+GET_CONFIG = 0x02
+SET_CONFIG = 0x03
+SET_SLOT_CONFIG = 0x04
+CLEAR_SLOT = 0x05
+GET_VALUES = 0x06
+LIST_FILES = 0x07
+READ_FILE = 0x08
+START_STREAM = 0x09
+STOP_STREAM = 0x0A
+STREAM_SAMPLE = EVENT | 0x01
+
+STATUS = {0: "ok", 1: "bad request", 2: "unknown operation", 3: "rejected", 4: "not found", 5: "too large"}
+OK = 0
+NOT_FOUND = 4
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT-FALSE, as src/utilities/crc.cpp."""
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray()
+    start = 0
+    while True:
+        run = 0
+        while start + run < len(data) and run < 254 and data[start + run] != 0:
+            run += 1
+        out.append(run + 1)
+        out += data[start:start + run]
+        start += run
+        if start >= len(data):
+            return bytes(out)
+        if run < 254:
+            start += 1
+
+
+def cobs_decode(data):
+    out = bytearray()
+    position = 0
+    while position < len(data):
+        code = data[position]
+        position += 1
+        if code == 0 or position + code - 1 > len(data):
+            return None
+        out += data[position:position + code - 1]
+        position += code - 1
+        if code != 0xFF and position < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+def frame(packet):
+    packet = bytes(packet) + struct.pack("<H", crc16(packet))
+    return bytes([SYNC]) + cobs_encode(packet) + bytes([SYNC])
+
+
+class Port:
+    """A raw serial port, the frames pulled out of whatever else the logger prints."""
+
+    def __init__(self, path, baud=termios.B115200):
+        self.fd = os.open(path, os.O_RDWR | os.O_NOCTTY)
+        attributes = termios.tcgetattr(self.fd)
+        attributes[0] = 0                                                 # iflag
+        attributes[1] = 0                                                 # oflag
+        attributes[2] = termios.CS8 | termios.CREAD | termios.CLOCAL      # cflag
+        attributes[3] = 0                                                 # lflag
+        attributes[4] = attributes[5] = baud
+        attributes[6][termios.VMIN] = 0
+        attributes[6][termios.VTIME] = 0
+        termios.tcsetattr(self.fd, termios.TCSANOW, attributes)
+        termios.tcflush(self.fd, termios.TCIOFLUSH)
+        self.pending = bytearray()
+
+    def write(self, data):
+        while data:
+            data = data[os.write(self.fd, data):]
+
+    def packets(self, timeout):
+        """Yields decoded packets with good crcs until nothing arrives for timeout seconds."""
+        while True:
+            while True:
+                start = self.pending.find(SYNC)
+                end = self.pending.find(SYNC, start + 1) if start >= 0 else -1
+                if end < 0:
+                    if start > 0:
+                        del self.pending[:start]  # text between frames
+                    break
+                encoded = bytes(self.pending[start + 1:end])
+                del self.pending[:end]  # the closing zero may open the next frame
+                packet = cobs_decode(encoded) if encoded else None
+                if packet and len(packet) >= 4 and struct.unpack_from("<H", packet, len(packet) - 2)[0] == crc16(packet[:-2]):
+                    del self.pending[:1]
+                    yield packet[:-2]
+            ready, _, _ = select.select([self.fd], [], [], timeout)
+            if not ready:
+                return
+            self.pending += os.read(self.fd, 4096)
+
+
+class Logger:
+    """Requests with sequence numbers, pipelined up to the logger's receive buffer."""
+
+    def __init__(self, port, on_event=None):
+        self.port = port
+        self.sequence = 0
+        self.on_event = on_event  # called with event packets that arrive while waiting for responses
+
+    def request(self, operation, body=b""):
+        return self.pipeline([(operation, body)])[0]
+
+    def pipeline(self, requests):
+        """Sends every request, returning (status, body) for each in order, resending the ones not answered."""
+        results = [None] * len(requests)
+        for _ in range(RETRIES):
+            outstanding = [i for i, result in enumerate(results) if result is None]
+            if not outstanding:
+                break
+            sent = {}      # sequence -> request index
+            in_flight = []  # (sequence, frame length)
+            queue = list(outstanding)
+            packets = None
+            while queue or in_flight:
+                while queue and (not in_flight or sum(length for _, length in in_flight) + self.frame_length(requests[queue[0]]) <= PIPELINE_BYTES):
+                    index = queue.pop(0)
+                    operation, body = requests[index]
+                    self.sequence = (self.sequence + 1) & 0xFF
+                    data = frame(bytes([operation, self.sequence]) + body)
+                    self.port.write(data)
+                    sent[self.sequence] = index
+                    in_flight.append((self.sequence, len(data)))
+                if packets is None:
+                    packets = self.port.packets(TIMEOUT)
+                packet = next(packets, None)
+                if packet is None:
+                    break  # the rest are resent
+                if packet[0] & EVENT and not packet[0] & RESPONSE:
+                    if self.on_event:
+                        self.on_event(packet)
+                    continue
+                if not packet[0] & RESPONSE or packet[1] not in sent:
+                    continue
+                index = sent.pop(packet[1])
+                results[index] = (packet[2], packet[3:])
+                in_flight = [(sequence, length) for sequence, length in in_flight if sequence != packet[1]]
+                packets = None
+        if any(result is None for result in results):
+            raise IOError("no response from the logger")
+        return results
+
+    @staticmethod
+    def frame_length(request):
+        operation, body = request
+        return len(frame(bytes([operation, 0]) + body))
+
+
+def check(status, what):
+    if status != OK:
+        raise IOError("%s: %s" % (what, STATUS.get(status, status)))
+
+
+def info(logger):
+    status, body = logger.request(INFO)
+    check(status, "info")
+    version, max_body, sensors = struct.unpack_from("<BHB", body)
+    firmware, uuid = body[4:].split(b"\0")[:2]
+    print("protocol %d firmware %s uuid %s sensors %d max body %d" % (version, firmware.decode(), uuid.decode(), sensors, max_body))
+
+
+def get_config(logger):
+    status, body = logger.request(INFO)
+    check(status, "info")
+    sensors = body[3]
+    for (status, body) in logger.pipeline([(GET_CONFIG, bytes([index])) for index in range(sensors + 1)]):
+        check(status, "get-config")
+        print(body.decode())
+
+
+def set_config(logger, path):
+    requests = []
+    with open(path) as f:
+        for line in f:
+            if line.strip():
+                config = json.loads(line)
+                operation = SET_SLOT_CONFIG if "slot" in config else SET_CONFIG
+                requests.append((operation, json.dumps(config, separators=(",", ":")).encode()))
+    failed = 0
+    for (status, _), (_, body) in zip(logger.pipeline(requests), requests):
+        if status != OK:
+            print("%s: %s" % (body.decode(), STATUS.get(status, status)))
+            failed += 1
+    return 1 if failed else 0
+
+
+def values(logger):
+    status, body = logger.request(GET_VALUES)
+    check(status, "values")
+    sys.stdout.write(body.decode())
+
+
+def list_files(logger, path=""):
+    entries = []
+    while True:
+        status, body = logger.request(LIST_FILES, struct.pack("<H", len(entries)) + path.encode())
+        check(status, "ls")
+        if not body:
+            return entries
+        position = 0
+        while position < len(body):
+            size, directory = struct.unpack_from("<IB", body, position)
+            end = body.index(b"\0", position + 5)
+            entries.append((body[position + 5:end].decode(), size, bool(directory)))
+            position = end + 1
+
+
+def export(logger, path, destination):
+    """Reads the file in pipelined chunks, which arrive in order."""
+    chunk = MAX_BODY - 4
+    with open(destination, "wb") as out:
+        offset = 0
+        while True:
+            requests = [(READ_FILE, struct.pack("<IH", offset + i * chunk, chunk) + path.encode()) for i in range(8)]
+            for status, body in logger.pipeline(requests):
+                check(status, path)
+                data = body[4:]
+                out.write(data)
+                offset += len(data)
+                if len(data) < chunk:
+                    return offset
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    logger = Logger(Port(sys.argv[1]))
+    command, arguments = sys.argv[2], sys.argv[3:]
+    if command == "info":
+        info(logger)
+    elif command == "get-config":
+        get_config(logger)
+    elif command == "set-config" and len(arguments) == 1:
+        sys.exit(set_config(logger, arguments[0]))
+    elif command == "values":
+        values(logger)
+    elif command == "ls" and len(arguments) <= 1:
+        for name, size, directory in list_files(logger, *arguments):
+            print("%s/" % name if directory else "%10d %s" % (size, name))
+    elif command == "export" and len(arguments) == 2:
+        print("%d bytes" % export(logger, *arguments))
+    else:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,124 @@
+#!/usr/bin/env python3
+#
+#  RRIV - Open Source Environmental Data Logging Platform
+#  Copyright (C) 20202  Zaven Arra  zaven.arra@gmail.com
+#
+#  This program is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  This program is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>
+
+"""Stream live samples from a logger to CSV, reporting dropped frames, until interrupted.
+
+  python3 tools/stream_receiver.py /dev/ttyACM0 samples.csv          every configured slot
+  python3 tools/stream_receiver.py /dev/ttyACM0 samples.csv 1 3      slots 1 and 3
+
+Each row is one sample: sequence, logger milliseconds, slot, then the columns of every
+streamed sensor with only the sampled slot's filled in.  Gaps in the sequence are frames
+the logger had no serial bandwidth for or that failed the crc on the way.
+"""
+
+import signal
+import struct
+import sys
+import time
+
+import rriv_protocol as protocol
+
+REPORT_SECONDS = 1.0
+
+
+class Receiver:
+    def __init__(self, out):
+        self.out = out
+        self.columns = {}  # slot -> (first column, column count)
+        self.width = 0
+        self.expected = None
+        self.received = 0
+        self.dropped = 0
+        self.wraps = 0
+        self.last_millis = None
+
+    def start(self, header):
+        names = []
+        position = 0
+        while position < len(header):
+            slot = header[position]
+            end = header.index(b"\0", position + 1)
+            headers = header[position + 1:end].decode().split(",")
+            self.columns[slot] = (len(names), len(headers))
+            names += headers
+            position = end + 1
+        self.width = len(names)
+        self.out.write(",".join(["sequence", "time_ms", "slot"] + names) + "\n")
+
+    def sample(self, packet):
+        if packet[0] != protocol.STREAM_SAMPLE:
+            return
+        sequence, millis, slot, count = struct.unpack_from("<IIBB", packet, 1)
+        values = struct.unpack_from("<%df" % count, packet, 11)
+
+        if self.expected is not None and sequence > self.expected:
+            self.dropped += sequence - self.expected
+        self.expected = sequence + 1
+        self.received += 1
+
+        # millis() wraps after 49 days, keep the column increasing
+        if self.last_millis is not None and millis < self.last_millis:
+            self.wraps += 1
+        self.last_millis = millis
+        millis += self.wraps << 32
+
+        row = [""] * self.width
+        first, width = self.columns.get(slot, (0, 0))
+        for i, value in enumerate(values[:width]):
+            row[first + i] = "%.6g" % value
+        self.out.write("%d,%d,%d,%s\n" % (sequence, millis, slot, ",".join(row)))
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.stderr.write(__doc__)
+        sys.exit(1)
+    slots = bytes(int(slot) for slot in sys.argv[3:])
+
+    with open(sys.argv[2], "w") as out:
+        receiver = Receiver(out)
+        logger = protocol.Logger(protocol.Port(sys.argv[1]), on_event=receiver.sample)
+        status, header = logger.request(protocol.START_STREAM, slots)
+        protocol.check(status, "start stream")
+        receiver.start(header)
+
+        stopping = []
+        signal.signal(signal.SIGINT, lambda *_: stopping.append(True))
+        started = reported = time.time()
+        last_received = 0
+        while not stopping:
+            for packet in logger.port.packets(REPORT_SECONDS):
+                receiver.sample(packet)
+                if stopping or time.time() - reported >= REPORT_SECONDS:
+                    break
+            now = time.time()
+            rate = (receiver.received - last_received) / (now - reported)
+            sys.stderr.write("\r%d samples %.1f/s dropped %d  " % (receiver.received, rate, receiver.dropped))
+            reported, last_received = now, receiver.received
+
+        status, body = logger.request(protocol.STOP_STREAM)
+        sys.stderr.write("\n")
+        if status == protocol.OK:
+            sent, dropped = struct.unpack("<II", body)
+            sys.stderr.write("logger sent %d, dropped %d for lack of serial bandwidth\n" % (sent, dropped))
+        elapsed = time.time() - started
+        sys.stderr.write("received %d in %.1fs, %d missing from the sequence\n" % (receiver.received, elapsed, receiver.dropped))
+
+
+if __name__ == "__main__":
+    main()